@@ -2,6 +2,7 @@
 #include <cmath>
 #include <cstdio>
 #include <algorithm>
+#include <cstddef>
 
 void VolEnv::tick(double delta_time, const VolEnvParams& params) {
     this->stage_time += delta_time;
@@ -68,3 +69,114 @@ void VolEnv::tick(double delta_time, const VolEnvParams& params) {
         }
     }
 }
+
+// Number of samples, counting from the next one, that still fall before `stage_length`
+static size_t samples_until(double stage_time, double stage_length, double delta_time, size_t n_samples) {
+    const double n_left = ceil((stage_length - stage_time) / delta_time) - 1.0;
+    if (n_left <= 0.0) return 0;
+    return (n_left >= (double)n_samples) ? n_samples : (size_t)n_left;
+}
+
+void VolEnv::render(float* output, size_t n_samples, double delta_time, const VolEnvParams& params, const float* sustain) {
+    const float sustain_constant = (float)params.sustain;
+    size_t i                     = 0;
+
+    while (i < n_samples) {
+        const size_t n_remaining = n_samples - i;
+        float* segment           = output + i;
+
+        if (this->stage == VolEnvStage::idle) {
+            this->adsr_volume = 0.0;
+            std::fill(segment, segment + n_remaining, 0.0f);
+            return;
+        }
+
+        if (this->stage == VolEnvStage::release) {
+            if (params.release == 0.0) {
+                this->stage      = VolEnvStage::idle;
+                this->stage_time = 0.0;
+                continue;
+            }
+
+            // Linear ramp down, the sample where it would reach zero is the first idle one
+            const float start = (float)this->adsr_volume;
+            const float step  = (float)(params.release * delta_time);
+            const size_t n    = samples_until(0.0, this->adsr_volume, params.release * delta_time, n_remaining);
+            for (size_t j = 0; j < n; ++j) segment[j] = start - step * (float)(j + 1);
+            this->adsr_volume -= params.release * delta_time * (double)n;
+            i += n;
+            if (n < n_remaining) {
+                this->stage      = VolEnvStage::idle;
+                this->stage_time = 0.0;
+            }
+            continue;
+        }
+
+        if (this->stage == VolEnvStage::sustain) {
+            // Only a sustain level of zero ends this stage
+            size_t n = n_remaining;
+            if (sustain != nullptr) {
+                for (size_t j = 0; j < n_remaining; ++j) {
+                    if (sustain[i + j] == 0.0f) {
+                        n = j;
+                        break;
+                    }
+                }
+                std::copy(sustain + i, sustain + i + n, segment);
+                if (n > 0) this->adsr_volume = sustain[i + n - 1];
+            } else {
+                if (sustain_constant == 0.0f) n = 0;
+                std::fill(segment, segment + n, sustain_constant);
+                if (n > 0) this->adsr_volume = sustain_constant;
+            }
+            this->stage_time += delta_time * (double)n;
+            i += n;
+            if (n < n_remaining) {
+                this->stage      = VolEnvStage::idle;
+                this->stage_time = 0.0;
+            }
+            continue;
+        }
+
+        // The timed stages: figure out how many samples are left in this one, render those in one go, and then move on to
+        // the next stage
+        // The stages from delay to decay follow each other in the enum
+        const double stage_lengths[] = {0.0, params.delay, params.attack, params.hold, params.decay};
+        const double stage_length    = stage_lengths[(size_t)this->stage];
+        const VolEnvStage next       = (VolEnvStage)((size_t)this->stage + 1);
+
+        const size_t n = samples_until(this->stage_time, stage_length, delta_time, n_remaining);
+        if (n > 0) {
+            const float time  = (float)this->stage_time;
+            const float dt    = (float)delta_time;
+            const float scale = (float)(1.0 / stage_length);
+            if (this->stage == VolEnvStage::delay) {
+                std::fill(segment, segment + n, 0.0f);
+            } else if (this->stage == VolEnvStage::attack) {
+                for (size_t j = 0; j < n; ++j) segment[j] = (time + dt * (float)(j + 1)) * scale;
+            } else if (this->stage == VolEnvStage::hold) {
+                std::fill(segment, segment + n, 1.0f);
+            } else if (sustain != nullptr) {
+                for (size_t j = 0; j < n; ++j) {
+                    const float t = (time + dt * (float)(j + 1)) * scale;
+                    segment[j]    = 1.0f + (sustain[i + j] - 1.0f) * t;
+                }
+            } else {
+                for (size_t j = 0; j < n; ++j) {
+                    const float t = (time + dt * (float)(j + 1)) * scale;
+                    segment[j]    = 1.0f + (sustain_constant - 1.0f) * t;
+                }
+            }
+            this->adsr_volume = segment[n - 1];
+            this->stage_time += delta_time * (double)n;
+            i += n;
+        }
+
+        // The next sample falls in the next stage. That stage starts rendering at the same sample, just like tick() falls
+        // through to the next stage in the same call.
+        if (n < n_remaining) {
+            this->stage_time -= stage_length;
+            this->stage = next;
+        }
+    }
+}
\ No newline at end of file
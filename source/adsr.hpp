@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 
 // todo: PascalCase as per naming convention
 enum class VolEnvStage {
@@ -28,4 +29,9 @@ struct VolEnv {
     VolEnvStage stage  = VolEnvStage::idle; // What stage we're at now
 
     void tick(double delta_time, const VolEnvParams& params);
+
+    // Same as calling tick() `n_samples` times and writing adsr_volume to `output` after each one, but renders each stage
+    // as one segment, so the stage logic only runs when a stage ends. `sustain` optionally points to one sustain level per
+    // sample, overriding params.sustain.
+    void render(float* output, size_t n_samples, double delta_time, const VolEnvParams& params, const float* sustain = nullptr);
 };
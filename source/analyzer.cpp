@@ -0,0 +1,199 @@
+#include "analyzer.hpp"
+#include "common.hpp"
+#include "fft.hpp"
+#include "log.hpp"
+#include "mixer.hpp"
+#include "spsc_ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ANALYZER_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace Analyzer {
+    // Interleaved stereo, written by the audio thread. Big enough for a few of the largest blocks, so the analysis thread can
+    // take a nap between reads.
+    SpscRing<float, 1 << 16> tap;
+    // Rate of the samples in the tap. Stored before the samples are pushed, so it's up to date by the time they're popped.
+    std::atomic<double> tap_sample_rate = 44100.0;
+
+    // Written by the analysis thread, copied out by the readers. Neither of them is real-time, so a mutex is fine here.
+    struct {
+        std::mutex mutex;
+        std::vector<float> scope;
+        std::vector<float> spectrum_db;
+        double bin_hz = 0.0;
+        bool has_data = false;
+    } results;
+
+    // Declared after the results, so it gets destroyed and joined before them
+    struct AnalysisThread {
+        ~AnalysisThread() { shutdown(); }
+
+        std::thread thread;
+        std::atomic<bool> running = false;
+    } analysis_thread;
+
+    Params::Handle hop_size = Params::invalid;
+
+    void write(const float* buffer, size_t n_frames, double sample_rate) {
+        if (!analysis_thread.running.load(std::memory_order_relaxed)) return;
+        tap_sample_rate.store(sample_rate, std::memory_order_relaxed);
+        tap.push(buffer, 2 * n_frames);
+    }
+
+    // output[i] = input[i] * window[i], for a whole frame
+    static void apply_window(float* output, const float* input, const float* window) {
+        static_assert(fft_size % 4 == 0);
+#ifdef ANALYZER_SSE2
+        for (size_t i = 0; i < fft_size; i += 4) {
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), _mm_loadu_ps(window + i)));
+        }
+#else
+        for (size_t i = 0; i < fft_size; ++i) {
+            output[i] = input[i] * window[i];
+        }
+#endif
+    }
+
+    // Squared magnitude of every bin
+    static void power(float* output, const std::complex<float>* bins, size_t n_bins) {
+        const float* values = reinterpret_cast<const float*>(bins);
+        size_t i            = 0;
+#ifdef ANALYZER_SSE2
+        for (; i + 2 <= n_bins; i += 2) {
+            // re0 im0 re1 im1, squared and added pairwise, leaves the results in lanes 0 and 2
+            __m128 squares = _mm_loadu_ps(values + 2 * i);
+            squares        = _mm_mul_ps(squares, squares);
+            squares        = _mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1)));
+            float lanes[4];
+            _mm_storeu_ps(lanes, squares);
+            output[i + 0] = lanes[0];
+            output[i + 1] = lanes[2];
+        }
+#endif
+        for (; i < n_bins; ++i) {
+            output[i] = std::norm(bins[i]);
+        }
+    }
+
+    static void analysis_main() {
+        constexpr size_t n_bins = fft_size / 2 + 1;
+
+        // Mono mix of the most recent samples, oldest first. A frame can end up to a hop before the newest sample, and the
+        // hop can be as long as the frame.
+        std::vector<float> history(2 * fft_size, 0.0f);
+        std::vector<float> incoming(2 * Mixer::max_block_frames);
+        std::vector<float> window(fft_size);
+        std::vector<float> windowed(fft_size);
+        std::vector<std::complex<float>> bins(n_bins);
+        std::vector<float> powers(n_bins);
+        std::vector<float> scope(scope_frames);
+        std::vector<float> spectrum_db(n_bins);
+
+        // Periodic Hann window. A sine's energy ends up in its bin with a gain of sum(window) / 2, so scaling by the inverse
+        // of that makes a full scale sine read 0 dB.
+        double window_sum = 0.0;
+        for (size_t i = 0; i < fft_size; ++i) {
+            window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)fft_size));
+            window_sum += window[i];
+        }
+        const double amplitude_scale = 2.0 / window_sum;
+        const double power_offset_db = 20.0 * log10(amplitude_scale);
+
+        size_t samples_since_frame = 0;
+        while (analysis_thread.running.load(std::memory_order_relaxed)) {
+            // Everything the audio thread wrote since the last pass
+            size_t n_samples;
+            while ((n_samples = tap.pop(incoming.data(), incoming.size())) > 0) {
+                const size_t n_frames = n_samples / 2;
+                memmove(history.data(), history.data() + n_frames, sizeof(float) * (history.size() - n_frames));
+                float* newest = history.data() + history.size() - n_frames;
+                for (size_t i = 0; i < n_frames; ++i) {
+                    newest[i] = 0.5f * (incoming[2 * i + 0] + incoming[2 * i + 1]);
+                }
+                samples_since_frame += n_frames;
+            }
+
+            const size_t hop = std::clamp((size_t)Params::get(hop_size), min_hop_size, fft_size);
+            if (samples_since_frame < hop) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
+            }
+
+            // Only the newest frame gets analyzed, the UI would only ever show the last one anyway. It still ends on the hop
+            // grid, so the hop size sets how the frames overlap.
+            samples_since_frame %= hop;
+            const float* frame = history.data() + history.size() - fft_size - samples_since_frame;
+            apply_window(windowed.data(), frame, window.data());
+            FFT::forward_real(windowed.data(), bins.data(), fft_size);
+            power(powers.data(), bins.data(), n_bins);
+            for (size_t i = 0; i < n_bins; ++i) {
+                spectrum_db[i] = (float)(10.0 * log10(std::max((double)powers[i], 1e-20)) + power_offset_db);
+            }
+
+            // Start the scope at the latest rising zero crossing that still leaves a full scope's worth of samples after it
+            const size_t latest_start = history.size() - scope_frames;
+            size_t scope_start        = latest_start;
+            for (size_t i = latest_start; i > latest_start - scope_frames; --i) {
+                if (history[i - 1] < 0.0f && history[i] >= 0.0f) {
+                    scope_start = i;
+                    break;
+                }
+            }
+            memcpy(scope.data(), history.data() + scope_start, sizeof(float) * scope_frames);
+
+            std::lock_guard<std::mutex> lock(results.mutex);
+            results.scope.swap(scope);
+            results.spectrum_db.swap(spectrum_db);
+            results.bin_hz   = tap_sample_rate.load(std::memory_order_relaxed) / (double)fft_size;
+            results.has_data = true;
+            scope.resize(scope_frames);
+            spectrum_db.resize(n_bins);
+        }
+    }
+
+    void init() {
+        if (analysis_thread.running.load()) return;
+        if (hop_size == Params::invalid) hop_size = Params::create("analyzer_hop_size", 1024.0);
+
+        // Throw away whatever is left over from a previous run
+        std::vector<float> discard(tap.capacity());
+        tap.pop(discard.data(), discard.size());
+
+        analysis_thread.running.store(true);
+        analysis_thread.thread = std::thread(analysis_main);
+        LOG(Info, "Analyzer running, %zu point FFT", fft_size);
+    }
+
+    void shutdown() {
+        analysis_thread.running.store(false);
+        if (analysis_thread.thread.joinable()) analysis_thread.thread.join();
+    }
+
+    Params::Handle hop_size_param() { return hop_size; }
+
+    bool read_scope(std::vector<float>& samples) {
+        std::lock_guard<std::mutex> lock(results.mutex);
+        if (!results.has_data) return false;
+        samples = results.scope;
+        return true;
+    }
+
+    bool read_spectrum(std::vector<float>& magnitudes_db, double& bin_hz) {
+        std::lock_guard<std::mutex> lock(results.mutex);
+        if (!results.has_data) return false;
+        magnitudes_db = results.spectrum_db;
+        bin_hz        = results.bin_hz;
+        return true;
+    }
+} // namespace Analyzer
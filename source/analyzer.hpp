@@ -0,0 +1,31 @@
+#pragma once
+#include "parameters.hpp"
+#include <cstddef>
+#include <vector>
+
+// Oscilloscope and spectrum analyzer for the output of the master bus. The audio thread copies every block it renders into
+// a wait-free ring, and a thread of its own turns that into a waveform and a Hann windowed spectrum every
+// `analyzer_hop_size` samples. The audio thread never waits or allocates: if the analysis thread falls behind, blocks get
+// dropped from the ring instead.
+namespace Analyzer {
+    constexpr size_t fft_size     = 4096;
+    constexpr size_t scope_frames = 1024;
+    constexpr size_t min_hop_size = 64;
+
+    // Audio thread. Copy a block of interleaved stereo at `sample_rate` into the tap, if the analysis thread is running.
+    void write(const float* buffer, size_t n_frames, double sample_rate);
+
+    // Start and stop the analysis thread. Call these from the UI thread.
+    void init();
+    void shutdown();
+    // Samples between the starts of two analyzed frames, clamped to [min_hop_size, fft_size]. Created by init().
+    Params::Handle hop_size_param();
+
+    // The latest results. These lock, so don't call them from the audio thread. They return false until the first frame
+    // has been analyzed.
+    //
+    // Mono mix of scope_frames frames, starting at a rising zero crossing when there is one so periodic signals stand still
+    bool read_scope(std::vector<float>& samples);
+    // Magnitude of every bin from DC up to Nyquist in dBFS, a full scale sine reads 0 dB. `bin_hz` is the width of a bin.
+    bool read_spectrum(std::vector<float>& magnitudes_db, double& bin_hz);
+} // namespace Analyzer
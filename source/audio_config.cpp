@@ -0,0 +1,27 @@
+#include "audio_config.hpp"
+#include "log.hpp"
+#include <cstdio>
+#include <cstdint>
+
+#define TOML_EXCEPTIONS 0
+#include <toml++/toml.hpp>
+
+bool AudioConfig::load(const char* path) {
+    // No config file is fine, we just keep the defaults
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return true;
+    fclose(file);
+
+    auto config = toml::parse_file(path);
+    if (config.failed()) {
+        LOG(Error, "Failed to parse audio config \"%s\": %s", path, std::string(config.error().description()).c_str());
+        return false;
+    }
+
+    auto audio        = config["audio"];
+    this->device_name = audio["device"].value_or(this->device_name);
+    this->sample_rate = audio["sample_rate"].value_or(this->sample_rate);
+    this->block_size  = (size_t)audio["block_size"].value_or((int64_t)this->block_size);
+    this->latency_ms  = audio["latency_ms"].value_or(this->latency_ms);
+    return true;
+}
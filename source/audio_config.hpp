@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Settings for the audio output stream. They live in a small TOML file, so every machine can pick its own trade-off between
+// latency and CPU load. The file has a single [audio] table, with the same keys as the fields below.
+struct AudioConfig {
+    static constexpr const char* default_path = "audio_config.toml";
+
+    // Read the settings from `path`. Settings that are missing from the file keep their current value. Returns false if
+    // the file exists but could not be parsed.
+    bool load(const char* path);
+
+    std::string device_name; // Stored as "device". Empty means the system's default output device
+    double sample_rate = 44100.0;
+    size_t block_size  = 0;   // In frames, 0 lets the driver pick
+    double latency_ms  = 0.0; // Suggested output latency, 0 uses the device's default low latency
+};
@@ -0,0 +1,182 @@
+#include "audio_graph.hpp"
+#include "log.hpp"
+#include <algorithm>
+
+AudioGraph::AudioGraph() { this->nodes.push_back({NodeType::master, nullptr, "Master"}); }
+
+AudioGraph::NodeID AudioGraph::add_processor(std::shared_ptr<Processor> processor, const std::string& name) {
+    this->nodes.push_back({NodeType::processor, std::move(processor), name});
+    return this->nodes.size() - 1;
+}
+
+AudioGraph::NodeID AudioGraph::add_bus(const std::string& name) {
+    this->nodes.push_back({NodeType::bus, nullptr, name});
+    return this->nodes.size() - 1;
+}
+
+void AudioGraph::remove_node(NodeID node) {
+    if (node == master || node >= this->nodes.size()) return;
+
+    this->nodes[node] = {};
+    std::erase_if(this->edges, [node](const Edge& edge) { return edge.source == node || edge.dest == node; });
+}
+
+bool AudioGraph::connect(NodeID source, NodeID dest, float gain) {
+    if (source >= this->nodes.size() || this->nodes[source].type == NodeType::none) return false;
+    if (dest >= this->nodes.size() || this->nodes[dest].type == NodeType::none) return false;
+    if (source == master) return false;
+
+    // Adding source -> dest closes a loop if dest already feeds into source
+    if (source == dest || this->depends_on(source, dest)) {
+        LOG(Warning, "Can not connect \"%s\" to \"%s\", that would create a feedback loop", this->nodes[source].name.c_str(),
+            this->nodes[dest].name.c_str());
+        return false;
+    }
+
+    if (this->set_gain(source, dest, gain)) return true;
+    this->edges.push_back({source, dest, gain});
+    return true;
+}
+
+void AudioGraph::disconnect(NodeID source, NodeID dest) {
+    std::erase_if(this->edges, [=](const Edge& edge) { return edge.source == source && edge.dest == dest; });
+}
+
+bool AudioGraph::set_gain(NodeID source, NodeID dest, float gain) {
+    for (auto& edge: this->edges) {
+        if (edge.source == source && edge.dest == dest) {
+            edge.gain = gain;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AudioGraph::depends_on(NodeID node, NodeID other) const {
+    std::vector<bool> visited(this->nodes.size(), false);
+    std::vector<NodeID> stack = {node};
+    while (!stack.empty()) {
+        const NodeID current = stack.back();
+        stack.pop_back();
+        for (const auto& edge: this->edges) {
+            if (edge.dest != current || visited[edge.source]) continue;
+            if (edge.source == other) return true;
+            visited[edge.source] = true;
+            stack.push_back(edge.source);
+        }
+    }
+    return false;
+}
+
+double AudioGraph::latency(NodeID node) const {
+    if (node >= this->nodes.size()) return 0.0;
+
+    double input_latency = 0.0;
+    for (const auto& edge: this->edges) {
+        if (edge.dest == node) input_latency = std::max(input_latency, this->latency(edge.source));
+    }
+
+    const auto& processor = this->nodes[node].processor;
+    return input_latency + ((processor != nullptr) ? processor->latency_samples() : 0.0);
+}
+
+std::unique_ptr<GraphSchedule> AudioGraph::compile(size_t buffer_frames) const {
+    const size_t n_nodes = this->nodes.size();
+    auto schedule        = std::make_unique<GraphSchedule>();
+
+    // Only nodes that end up in the master are worth running
+    std::vector<bool> live(n_nodes, false);
+    std::vector<NodeID> stack = {master};
+    live[master]              = true;
+    while (!stack.empty()) {
+        const NodeID current = stack.back();
+        stack.pop_back();
+        for (const auto& edge: this->edges) {
+            if (edge.dest != current || live[edge.source]) continue;
+            live[edge.source] = true;
+            stack.push_back(edge.source);
+        }
+    }
+
+    // Kahn's algorithm, keeping track of the longest path to each node so we know which level it can run in
+    constexpr size_t unscheduled = (size_t)-1;
+    std::vector<size_t> n_pending_inputs(n_nodes, 0);
+    std::vector<size_t> level(n_nodes, 0);
+    std::vector<size_t> last_reader_level(n_nodes, unscheduled);
+    for (const auto& edge: this->edges) {
+        if (live[edge.source] && live[edge.dest]) n_pending_inputs[edge.dest]++;
+    }
+
+    std::vector<NodeID> order;
+    for (NodeID node = 0; node < n_nodes; ++node) {
+        if (live[node] && n_pending_inputs[node] == 0) order.push_back(node);
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        const NodeID node = order[i];
+        for (const auto& edge: this->edges) {
+            if (edge.source != node || !live[edge.dest]) continue;
+            level[edge.dest] = std::max(level[edge.dest], level[node] + 1);
+            if (--n_pending_inputs[edge.dest] == 0) order.push_back(edge.dest);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](NodeID a, NodeID b) { return level[a] < level[b]; });
+
+    for (const auto& edge: this->edges) {
+        if (!live[edge.source] || !live[edge.dest]) continue;
+        const size_t reader_level = level[edge.dest];
+        if (last_reader_level[edge.source] == unscheduled || last_reader_level[edge.source] < reader_level) {
+            last_reader_level[edge.source] = reader_level;
+        }
+    }
+
+    // Assign buffers level by level. A buffer goes back to the free list after the last level that reads from it, since
+    // everything within a level may run at the same time.
+    std::vector<size_t> node_buffer(n_nodes, 0);
+    std::vector<size_t> free_buffers;
+    for (size_t begin = 0; begin < order.size();) {
+        const size_t current_level = level[order[begin]];
+        size_t end                 = begin;
+        while (end < order.size() && level[order[end]] == current_level) ++end;
+
+        schedule->level_offsets.push_back(begin);
+        for (size_t i = begin; i < end; ++i) {
+            const NodeID node = order[i];
+            if (free_buffers.empty()) {
+                node_buffer[node] = schedule->n_buffers++;
+            } else {
+                node_buffer[node] = free_buffers.back();
+                free_buffers.pop_back();
+            }
+
+            GraphSchedule::Step step{};
+            step.processor     = this->nodes[node].processor.get();
+            step.output_buffer = node_buffer[node];
+            step.first_input   = schedule->inputs.size();
+            for (const auto& edge: this->edges) {
+                if (edge.dest != node || !live[edge.source]) continue;
+                schedule->inputs.push_back({node_buffer[edge.source], edge.gain});
+            }
+            step.n_inputs = schedule->inputs.size() - step.first_input;
+            schedule->steps.push_back(step);
+
+            if (this->nodes[node].processor) schedule->processors.push_back(this->nodes[node].processor);
+        }
+
+        for (size_t i = 0; i < end; ++i) {
+            if (last_reader_level[order[i]] == current_level) free_buffers.push_back(node_buffer[order[i]]);
+        }
+        begin = end;
+    }
+    schedule->level_offsets.push_back(order.size());
+
+    for (NodeID node = 0; node < n_nodes; ++node) {
+        if (live[node] || this->nodes[node].processor == nullptr) continue;
+        schedule->unreachable.push_back(this->nodes[node].processor.get());
+        schedule->processors.push_back(this->nodes[node].processor);
+    }
+
+    schedule->master_buffer = node_buffer[master];
+    schedule->buffer_frames = buffer_frames;
+    schedule->buffer_memory.resize(schedule->n_buffers * 2 * buffer_frames, 0.0f);
+    return schedule;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "processor.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class NodeType {
+    none = 0, // Removed node, its slot is kept so node IDs stay stable
+    master,
+    bus,
+    processor,
+};
+
+// Compiled form of an AudioGraph. It is immutable once built, so the audio thread can run it while the UI thread edits the
+// graph and compiles the next one.
+struct GraphSchedule {
+    struct Input {
+        size_t buffer;
+        float gain;
+    };
+
+    struct Step {
+        Processor* processor; // nullptr for buses and the master
+        size_t output_buffer;
+        size_t first_input; // Range into `inputs`
+        size_t n_inputs;
+    };
+
+    // Steps in topological order. Steps within a level don't depend on each other, so they can run in parallel. Level `i`
+    // is the range [level_offsets[i], level_offsets[i + 1]).
+    std::vector<Step> steps;
+    std::vector<Input> inputs;
+    std::vector<size_t> level_offsets;
+
+    // Buffers are reused once every node that reads them has run, so the count depends on how wide the graph is rather
+    // than how many nodes it has
+    size_t n_buffers     = 0;
+    size_t buffer_frames = 0;
+    size_t master_buffer = 0;
+    std::vector<float> buffer_memory;
+
+    // Processors that don't end up in the master. They don't get rendered, but their event queues still get drained.
+    std::vector<Processor*> unreachable;
+
+    // Keeps the processors alive for as long as the schedule is in use
+    std::vector<std::shared_ptr<Processor>> processors;
+
+    size_t n_levels() const { return level_offsets.empty() ? 0 : level_offsets.size() - 1; }
+    float* buffer(size_t index) { return buffer_memory.data() + index * 2 * buffer_frames; }
+};
+
+// Directed acyclic graph of processors and buses that ends in a single master node. Processor nodes render on top of the
+// sum of their inputs (so effects process their inputs in place), buses just sum their inputs. Edges carry a gain, which
+// is how sends to effect returns are expressed.
+struct AudioGraph {
+    using NodeID                  = size_t;
+    static constexpr NodeID master = 0;
+
+    struct Node {
+        NodeType type = NodeType::none;
+        std::shared_ptr<Processor> processor;
+        std::string name;
+    };
+
+    struct Edge {
+        NodeID source;
+        NodeID dest;
+        float gain;
+    };
+
+    AudioGraph();
+    NodeID add_processor(std::shared_ptr<Processor> processor, const std::string& name = "");
+    NodeID add_bus(const std::string& name);
+    void remove_node(NodeID node);
+    // Route `source` into `dest`. Returns false if either node doesn't exist, or if the edge would create a cycle.
+    bool connect(NodeID source, NodeID dest, float gain = 1.0f);
+    void disconnect(NodeID source, NodeID dest);
+    bool set_gain(NodeID source, NodeID dest, float gain);
+    bool depends_on(NodeID node, NodeID other) const;
+    // Latency of the slowest path from any processor into `node`, in samples. Paths are not delay compensated.
+    double latency(NodeID node) const;
+    std::unique_ptr<GraphSchedule> compile(size_t buffer_frames) const;
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+};
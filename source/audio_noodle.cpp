@@ -1,18 +1,168 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "analyzer.hpp"
 #include "midi.hpp"
 #include "mixer.hpp"
 #include "session.hpp"
+#include "parameters.hpp"
+#include "realtime.hpp"
 #include "ui/scene.hpp"
 #include "ui/panel.hpp"
 #include "ui/components.hpp"
 #include "ui/panel_manager.hpp"
 #include "graphics/renderer.hpp"
+#include "processors/wavetable_osc.hpp"
+#include "voice_allocator.hpp"
+#include "xruns.hpp"
+
+// Copy levels into the values a UI::Meter named `name` reads
+void update_meter(UI::ValuePool& values, const std::string& name, const LevelMeter::Snapshot& levels) {
+    values.get<glm::vec2>(name + "_peak") = {levels.peak[0], levels.peak[1]};
+    values.get<glm::vec2>(name + "_rms")  = {levels.rms[0], levels.rms[1]};
+    values.get<glm::vec2>(name + "_hold") = {levels.peak_hold[0], levels.peak_hold[1]};
+}
+
+// Every track's processor panel has a meter for the track's output
+void update_track_meters() {
+    for (const auto& track: Session::tracks()) {
+        const size_t panel_index = track->debug_processor->ui_panel_index;
+        if (panel_index == (size_t)-1) continue;
+        update_meter(UI::get_panel(panel_index).scene.value_pool, "output_meter", Mixer::levels(track->mixer_node));
+    }
+}
+
+// Copy the latest performance numbers into the performance panel
+void update_performance_panel(size_t panel_index) {
+    if (panel_index == (size_t)-1) return;
+
+    auto& values                         = UI::get_panel(panel_index).scene.value_pool;
+    const Mixer::DspLoad load            = Mixer::dsp_load();
+    const TimingStats::Snapshot callback = Mixer::callback_timing();
+    values.get<double>("dsp_load")        = load.current * 100.0;
+    values.get<double>("dsp_load_peak")   = load.peak * 100.0;
+    values.get<double>("callback_avg_us") = callback.avg_us;
+    values.get<double>("callback_max_us") = callback.max_us;
+    values.get<double>("active_voices")   = (double)VoiceAllocator::n_global_voices();
+
+    const Xruns::Counters xruns = Xruns::counters();
+    values.get<double>("underflows")     = (double)xruns.n_underflows;
+    values.get<double>("late_callbacks") = (double)xruns.n_late_callbacks;
+
+    update_meter(values, "master_meter", Mixer::levels(Mixer::master_node()));
+}
+
+// Hand the latest waveform and spectrum to the analyzer panel. The panel keeps pointers to these vectors.
+void update_analyzer_panel(size_t panel_index) {
+    if (panel_index == (size_t)-1) return;
+
+    static std::vector<float> scope;
+    static std::vector<float> spectrum;
+    static double bin_hz = 0.0;
+    Analyzer::read_scope(scope);
+    Analyzer::read_spectrum(spectrum, bin_hz);
+
+    auto& values = UI::get_panel(panel_index).scene.value_pool;
+    values.set_ptr("scope", &scope);
+    values.set_ptr("spectrum", &spectrum);
+    values.get<double>("spectrum_bin_hz") = bin_hz;
+}
+
+// Note pattern for headless renders, so there is something to hear and the engine has voices to render. Every two seconds
+// a held chord plus an arpeggio over it in eighth notes, cycling through Am, F, C and G.
+struct RenderEvent {
+    uint64_t position; // In samples
+    uint8_t status;
+    uint8_t key;
+    uint8_t velocity;
+};
+
+std::vector<RenderEvent> render_pattern(double length_sec, double sample_rate) {
+    constexpr double bar_sec       = 2.0;
+    constexpr double step_sec      = bar_sec / 8.0;
+    constexpr uint8_t chords[4][3] = {{57, 60, 64}, {53, 57, 60}, {48, 52, 55}, {55, 59, 62}};
+    constexpr size_t arpeggio[8]   = {0, 1, 2, 1, 0, 1, 2, 1};
+    const auto at = [sample_rate](double time_sec) { return (uint64_t)llround(time_sec * sample_rate); };
+
+    std::vector<RenderEvent> events;
+    for (size_t bar = 0; bar * bar_sec < length_sec; ++bar) {
+        const double bar_start = (double)bar * bar_sec;
+        const uint8_t* chord   = chords[bar % 4];
+        for (size_t i = 0; i < 3; ++i) {
+            events.push_back({at(bar_start), 0x90, chord[i], 70});
+            events.push_back({at(bar_start + bar_sec - step_sec / 2.0), 0x80, chord[i], 0});
+        }
+        for (size_t step = 0; step < 8; ++step) {
+            const double step_start = bar_start + (double)step * step_sec;
+            const uint8_t key       = (uint8_t)(chord[arpeggio[step]] + 12);
+            events.push_back({at(step_start), 0x90, key, 100});
+            events.push_back({at(step_start + step_sec * 0.8), 0x80, key, 0});
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const RenderEvent& a, const RenderEvent& b) {
+        return a.position < b.position;
+    });
+    return events;
+}
+
+int main(int argc, char** argv) {
+    // Headless mode: AudioNoodles --render <output.wav> [--length <seconds>] [--block-size <frames>]
+    //                             [--instrument wav_osc|wavetable] [--sample-rate <hz>] [--oversampling 1|2|4]
+    // The instrument plays render_pattern(), a loop of chords and arpeggios.
+    const char* render_path   = nullptr;
+    const char* instrument    = "wav_osc";
+    double render_length_sec  = 10.0;
+    size_t render_block_size  = 512;
+    double render_sample_rate = 44100.0;
+    size_t oversampling       = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--render") == 0 && i + 1 < argc) render_path = argv[++i];
+        else if (strcmp(argv[i], "--length") == 0 && i + 1 < argc) render_length_sec = atof(argv[++i]);
+        else if (strcmp(argv[i], "--block-size") == 0 && i + 1 < argc) render_block_size = (size_t)atoll(argv[++i]);
+        else if (strcmp(argv[i], "--instrument") == 0 && i + 1 < argc) instrument = argv[++i];
+        else if (strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) render_sample_rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--oversampling") == 0 && i + 1 < argc) oversampling = (size_t)atoll(argv[++i]);
+    }
+
+    if (render_path != nullptr) {
+        if (render_block_size == 0) render_block_size = 512;
+        AudioConfig render_config;
+        render_config.sample_rate = render_sample_rate;
+        if (!Mixer::set_audio_config(render_config)) return 1;
+        std::shared_ptr<Processor> processor;
+        if (strcmp(instrument, "wavetable") == 0) processor = std::make_shared<WavetableOsc>();
+        else processor = std::make_shared<WavOsc>();
+        Session::add_track(std::make_shared<Track>(std::move(processor), oversampling));
+
+        // Events go out on their exact sample, the block they land in is rendered right after
+        const std::vector<RenderEvent> events = render_pattern(render_length_sec, render_sample_rate);
+        size_t next_event                     = 0;
+        const auto dispatch_events            = [&](uint64_t block_offset, size_t n_frames) {
+            for (; next_event < events.size() && events[next_event].position < block_offset + n_frames; ++next_event) {
+                const RenderEvent& event = events[next_event];
+                Midi::MidiMessage message{};
+                message.status = event.status;
+                message.data1  = event.key;
+                message.data2  = event.velocity;
+                const uint64_t offset = event.position - std::min(event.position, block_offset);
+                Midi::dispatch(message, Mixer::block_start_sample() + offset);
+            }
+        };
+        return Mixer::render_offline(render_path, render_length_sec, render_block_size, dispatch_events) ? 0 : 1;
+    }
 
-int main() {
     Midi::init();
     Mixer::init();
     Gfx::init(Gfx::RenderAPI::OpenGL, 1280, 720, "Audio Noodles");
-    Session::tracks().push_back(Track{});
+    Session::create_track();
+    Realtime::lock_memory();
+    const size_t performance_panel = UI::load_panel("assets/layout/performance.toml", {0.0f, 460.0f});
+    const size_t analyzer_panel    = UI::load_panel("assets/layout/analyzer.toml", {720.0f, 460.0f});
+    Analyzer::init();
+    Params::bind_ui(Analyzer::hop_size_param(), analyzer_panel, "analyzer_hop_size");
 
     while (Gfx::should_stay_open()) {
         Gfx::set_cursor_mode(Gfx::CursorMode::Arrow);
@@ -20,10 +170,25 @@ int main() {
 
         Gfx::begin_frame();
         UI::panel_input();
+        Params::sync_ui();
+        update_performance_panel(performance_panel);
+        update_track_meters();
+        update_analyzer_panel(analyzer_panel);
+
+        // F3 prints the timing of the callback and every processor
+        if (Input::key_pressed(Input::Key::F3)) Mixer::dump_timing(stdout);
+        // F5 re-applies the audio config file, so the device, sample rate and block size can be changed while running
+        if (Input::key_pressed(Input::Key::F5)) {
+            AudioConfig config = Mixer::audio_config();
+            if (config.load(AudioConfig::default_path)) Mixer::set_audio_config(config);
+        }
         UI::panel_render();
         Gfx::end_frame();
 
-        // todo: move this to separate thread
-        Midi::process();
+        Midi::update();
+        Xruns::update();
+        Mixer::update();
     };
+
+    Analyzer::shutdown();
 }
@@ -0,0 +1,444 @@
+// Micro-benchmarks for the hot paths: the oscillator, the envelope, level metering, MIDI dispatch, scene views and 2D vertex
+// generation.
+// Results are written as JSON, so they can be compared across commits.
+//
+// AudioNoodlesBench [--output <results.json>] [--filter <substring>] [--min-time <seconds>] [--scalar]
+
+#include "adsr.hpp"
+#include "common.hpp"
+#include "level_meter.hpp"
+#include "log.hpp"
+#include "midi.hpp"
+#include "mixer.hpp"
+#include "parameters.hpp"
+#include "rcu.hpp"
+#include "realtime.hpp"
+#include "session.hpp"
+#include "graphics/renderer.hpp"
+#include "processors/wav_osc.hpp"
+#include "ui/components.hpp"
+#include "ui/panel_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct BenchParam {
+    std::string key;
+    std::string value;
+    bool is_number;
+};
+
+struct BenchResult {
+    std::string name;
+    std::vector<BenchParam> params;
+    size_t n_iterations = 0;
+    double median_ns    = 0.0; // Per iteration
+    double min_ns       = 0.0; // Per iteration
+    double n_samples    = 0.0; // Audio frames rendered per iteration, 0 if the benchmark doesn't render audio
+    double n_voices     = 0.0; // Voices sounding during the iteration
+    double n_items      = 0.0; // Work items per iteration, for the benchmarks that don't render audio
+    const char* item    = nullptr;
+};
+
+struct BenchOptions {
+    const char* output_path = nullptr;
+    const char* filter      = nullptr;
+    double min_time         = 0.2; // Seconds spent measuring each benchmark
+    bool scalar_kernels     = false;
+};
+
+BenchOptions options;
+std::vector<BenchResult> results;
+
+// Median is the number to track, min is the best case with a warm cache and no interruptions
+constexpr size_t n_batches = 16;
+
+BenchParam number_param(const char* key, double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%g", value);
+    return {key, buffer, true};
+}
+
+BenchParam string_param(const char* key, const char* value) { return {key, value, false}; }
+
+std::string bench_name(const char* base, const std::vector<BenchParam>& params) {
+    std::string name = base;
+    for (const auto& param: params) {
+        name += "/" + param.key + ":" + param.value;
+    }
+    return name;
+}
+
+bool bench_selected(const std::string& name) {
+    return options.filter == nullptr || name.find(options.filter) != std::string::npos;
+}
+
+// Runs `iteration` in batches. The batch size doubles until a batch takes long enough to time reliably, then n_batches
+// batches are timed, and the median and minimum time per iteration are reported.
+template <typename F> BenchResult measure(const std::string& name, F&& iteration) {
+    const int64_t batch_target_ns = (int64_t)(options.min_time * 1'000'000'000.0 / (double)n_batches);
+
+    size_t batch_size = 1;
+    while (true) {
+        const int64_t start_ns = Common::time_ns();
+        for (size_t i = 0; i < batch_size; ++i) iteration();
+        if (Common::time_ns() - start_ns >= batch_target_ns || batch_size >= ((size_t)1 << 30)) break;
+        batch_size *= 2;
+    }
+
+    std::vector<double> per_iteration_ns(n_batches);
+    for (auto& time_ns: per_iteration_ns) {
+        const int64_t start_ns = Common::time_ns();
+        for (size_t i = 0; i < batch_size; ++i) iteration();
+        time_ns = (double)(Common::time_ns() - start_ns) / (double)batch_size;
+    }
+    std::sort(per_iteration_ns.begin(), per_iteration_ns.end());
+
+    BenchResult result;
+    result.name         = name;
+    result.n_iterations = batch_size * n_batches;
+    result.median_ns    = (per_iteration_ns[n_batches / 2 - 1] + per_iteration_ns[n_batches / 2]) / 2.0;
+    result.min_ns       = per_iteration_ns[0];
+    return result;
+}
+
+void report(BenchResult result, std::vector<BenchParam> params) {
+    result.params = std::move(params);
+    if (result.n_samples > 0.0 && result.n_voices > 0.0) {
+        fprintf(stderr, "%-64s %10.1f ns %8.3f ns/sample/voice\n", result.name.c_str(), result.median_ns,
+                result.median_ns / result.n_samples / result.n_voices);
+    } else if (result.n_samples > 0.0) {
+        fprintf(stderr, "%-64s %10.1f ns %8.3f ns/sample\n", result.name.c_str(), result.median_ns,
+                result.median_ns / result.n_samples);
+    } else if (result.n_items > 0.0) {
+        fprintf(stderr, "%-64s %10.1f ns %8.3f ns/%s\n", result.name.c_str(), result.median_ns,
+                result.median_ns / result.n_items, result.item);
+    } else {
+        fprintf(stderr, "%-64s %10.1f ns\n", result.name.c_str(), result.median_ns);
+    }
+    results.push_back(std::move(result));
+}
+
+void bench_wav_osc() {
+    // One oscillator for every configuration, each one loads a UI panel and registers its own parameters
+    WavOsc osc;
+    if (options.scalar_kernels) osc.kernels = &OscKernels::scalar();
+    auto& handles = osc.param_handles;
+    Params::set(handles.adsr_sustain, 1.0); // Keep every voice in its sustain stage while it's being measured
+    std::vector<float> output(2 * Mixer::max_block_frames);
+
+    const WaveType wave_types[]  = {WaveType::sine, WaveType::square, WaveType::triangle, WaveType::sawtooth, WaveType::noise};
+    const char* wave_names[]     = {"sine", "square", "triangle", "sawtooth", "noise"};
+    const size_t note_counts[]   = {1, 8, 16};
+    const size_t unison_counts[] = {1, 4, 9};
+    const size_t block_sizes[]   = {64, 256, 1024};
+
+    for (size_t wave = 0; wave < std::size(wave_types); ++wave) {
+        for (const size_t n_notes: note_counts) {
+            for (const size_t n_unison: unison_counts) {
+                for (const size_t block_size: block_sizes) {
+                    std::vector<BenchParam> params = {
+                        string_param("wave", wave_names[wave]),
+                        number_param("notes", (double)n_notes),
+                        number_param("unison", (double)n_unison),
+                        number_param("block", (double)block_size),
+                    };
+                    const std::string name = bench_name("wav_osc", params);
+                    if (!bench_selected(name)) continue;
+
+                    // Start from silence, the wave type gets picked up by key_on() and the unison count by process_block()
+                    while (osc.allocator.n_active() > 0) osc.allocator.release(0);
+                    Params::set(handles.wave_type, (double)wave_types[wave] - 1.0);
+                    Params::set(handles.unison_count, (double)n_unison);
+                    osc.process_block(block_size, output.data());
+                    for (size_t note = 0; note < n_notes; ++note) {
+                        osc.key_on((uint8_t)(48 + 3 * note), 100);
+                    }
+                    // Get past the attack, and let the sustain level settle
+                    for (size_t i = 0; i < 64; ++i) osc.process_block(block_size, output.data());
+
+                    // The mixer hands processors a cleared buffer, so the clear is part of the measurement
+                    BenchResult result = measure(name, [&]() {
+                        memset(output.data(), 0, sizeof(float) * 2 * block_size);
+                        osc.process_block(block_size, output.data());
+                    });
+                    result.n_samples = (double)block_size;
+                    result.n_voices  = (double)osc.n_active_voices();
+                    report(std::move(result), std::move(params));
+                }
+            }
+        }
+    }
+    while (osc.allocator.n_active() > 0) osc.allocator.release(0);
+}
+
+void bench_vol_env() {
+    const double delta_time  = 1.0 / Mixer::sample_rate();
+    constexpr size_t n_ticks = 1024;
+    std::vector<float> output(n_ticks);
+
+    // Sustain is where voices spend most of their time, the decay stage exercises the exponential curve
+    const VolEnvStage stages[] = {VolEnvStage::decay, VolEnvStage::sustain};
+    const char* stage_names[]  = {"decay", "sustain"};
+    VolEnvParams params;
+    params.decay   = 1000.0; // Long enough to stay in the decay stage for the whole measurement
+    params.sustain = 0.5;
+
+    for (size_t stage = 0; stage < std::size(stages); ++stage) {
+        for (const char* method: {"tick", "render"}) {
+            std::vector<BenchParam> bench_params = {
+                string_param("stage", stage_names[stage]),
+                number_param("block", (double)n_ticks),
+            };
+            const std::string name = bench_name(strcmp(method, "tick") == 0 ? "vol_env_tick" : "vol_env_render", bench_params);
+            if (!bench_selected(name)) continue;
+
+            VolEnv env;
+            env.stage       = stages[stage];
+            env.adsr_volume = 1.0;
+            BenchResult result;
+            if (strcmp(method, "tick") == 0) {
+                result = measure(name, [&]() {
+                    env.stage_time = 0.0;
+                    for (size_t i = 0; i < n_ticks; ++i) {
+                        env.tick(delta_time, params);
+                        output[i] = (float)env.adsr_volume;
+                    }
+                });
+            } else {
+                result = measure(name, [&]() {
+                    env.stage_time = 0.0;
+                    env.render(output.data(), n_ticks, delta_time, params);
+                });
+            }
+            result.n_samples = (double)n_ticks;
+            result.n_voices  = 1.0;
+            report(std::move(result), std::move(bench_params));
+        }
+    }
+}
+
+// Every processor and the master get metered every block, so this has to stay a tiny fraction of the block's budget
+void bench_level_meter() {
+    for (const size_t block_size: {64, 256, 1024}) {
+        std::vector<BenchParam> bench_params = {number_param("block", (double)block_size)};
+        const std::string name               = bench_name("level_meter", bench_params);
+        if (!bench_selected(name)) continue;
+
+        std::vector<float> buffer(2 * block_size);
+        for (size_t i = 0; i < buffer.size(); ++i) {
+            buffer[i] = 0.5f * sinf((float)i * 0.01f);
+        }
+        LevelMeter meter;
+        BenchResult result = measure(name, [&]() { meter.process(buffer.data(), block_size, Mixer::sample_rate()); });
+        result.n_samples   = (double)block_size;
+        report(std::move(result), std::move(bench_params));
+    }
+}
+
+// Swallows the note events, so the benchmark only measures the dispatch
+struct NullProcessor : Processor {
+    void process_block(const size_t n_frames, float* output) override {}
+};
+
+void bench_midi_dispatch() {
+    std::vector<std::shared_ptr<Processor>> processors;
+    const size_t track_counts[] = {1, 8};
+    constexpr size_t n_messages = 256;
+
+    for (const size_t n_tracks: track_counts) {
+        std::vector<BenchParam> params = {
+            number_param("tracks", (double)n_tracks),
+            number_param("messages", (double)n_messages),
+        };
+        const std::string name = bench_name("midi_dispatch", params);
+        if (!bench_selected(name)) continue;
+
+        while (processors.size() < n_tracks) {
+            processors.push_back(std::make_shared<NullProcessor>());
+            Session::add_track(std::make_shared<Track>(processors.back()));
+        }
+
+        BenchResult result = measure(name, [&]() {
+            // Alternating note on and note off messages, like a fast passage on one channel
+            for (size_t i = 0; i < n_messages; ++i) {
+                Midi::MidiMessage message{};
+                message.status       = (i % 2 == 0) ? 0x90 : 0x80;
+                message.data1        = (uint8_t)(48 + (i / 2) % 24);
+                message.data2        = 100;
+                message.timestamp_ns = Common::time_ns();
+                Midi::queue_message(message);
+            }
+            Rcu::begin_read();
+            Midi::process();
+            Rcu::end_read();
+            for (const auto& processor: processors) {
+                while (processor->event_queue.peek() != nullptr) processor->event_queue.drop_front();
+            }
+        });
+        result.n_items = (double)n_messages;
+        result.item    = "message";
+        report(std::move(result), std::move(params));
+        Mixer::update();
+    }
+}
+
+void bench_scene_view() {
+    // The oscillator's panel is the biggest one we have
+    WavOsc osc;
+    UI::Scene& scene = UI::get_panel(osc.ui_panel_index).scene;
+
+    {
+        std::vector<BenchParam> params = {number_param("components", 1.0)};
+        const std::string name         = bench_name("scene_view", params);
+        if (bench_selected(name)) {
+            size_t n_entities  = 0;
+            BenchResult result = measure(name, [&]() { n_entities = scene.view<UI::Transform>().n_entities; });
+            result.n_items     = (double)std::max(n_entities, (size_t)1);
+            result.item        = "entity";
+            report(std::move(result), std::move(params));
+        }
+    }
+    {
+        std::vector<BenchParam> params = {number_param("components", 4.0)};
+        const std::string name         = bench_name("scene_view", params);
+        if (bench_selected(name)) {
+            size_t n_entities  = 0;
+            BenchResult result = measure(name, [&]() {
+                n_entities = scene.view<UI::Transform, UI::Value, UI::NumberRange, UI::WheelKnob>().n_entities;
+            });
+            result.n_items = (double)std::max(n_entities, (size_t)1);
+            result.item    = "entity";
+            report(std::move(result), std::move(params));
+        }
+    }
+}
+
+void bench_vertex_generation() {
+    constexpr size_t n_shapes = 256;
+    const char* shapes[]      = {"rectangle", "rectangle_outline", "circle", "line"};
+
+    for (const char* shape: shapes) {
+        std::vector<BenchParam> params = {
+            string_param("shape", shape),
+            number_param("count", (double)n_shapes),
+        };
+        const std::string name = bench_name("vertex_generation", params);
+        if (!bench_selected(name)) continue;
+
+        BenchResult result = measure(name, [&]() {
+            for (size_t i = 0; i < n_shapes; ++i) {
+                const glm::vec2 top_left = {(float)(i % 16) * 40.0f, (float)(i / 16) * 40.0f};
+                const glm::vec2 size     = {32.0f, 32.0f};
+                if (strcmp(shape, "rectangle") == 0) {
+                    Gfx::draw_rectangle_2d_pixels(top_left, top_left + size);
+                } else if (strcmp(shape, "rectangle_outline") == 0) {
+                    Gfx::draw_rectangle_2d_pixels(top_left, top_left + size, {.shape_outline_width = 2.0f});
+                } else if (strcmp(shape, "circle") == 0) {
+                    Gfx::draw_circle_2d_pixels(top_left, size);
+                } else {
+                    Gfx::draw_line_2d_pixels(top_left, top_left + size);
+                }
+            }
+            Gfx::discard_frame();
+        });
+        result.n_items = (double)n_shapes;
+        result.item    = "shape";
+        report(std::move(result), std::move(params));
+    }
+}
+
+void write_json_string(FILE* file, const std::string& string) {
+    fputc('"', file);
+    for (const char c: string) {
+        if (c == '"' || c == '\\') fputc('\\', file);
+        fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+void write_json(FILE* file, const char* kernels) {
+#ifdef _DEBUG
+    const char* build_type = "debug";
+#else
+    const char* build_type = "release";
+#endif
+    fprintf(file, "{\n");
+    fprintf(file, "  \"context\": {\n");
+    fprintf(file, "    \"sample_rate\": %g,\n", Mixer::sample_rate());
+    fprintf(file, "    \"osc_kernels\": \"%s\",\n", kernels);
+    fprintf(file, "    \"build_type\": \"%s\",\n", build_type);
+    fprintf(file, "    \"min_time_sec\": %g\n", options.min_time);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        fprintf(file, "    {\n      \"name\": ");
+        write_json_string(file, result.name);
+        fprintf(file, ",\n      \"params\": {");
+        for (size_t j = 0; j < result.params.size(); ++j) {
+            const BenchParam& param = result.params[j];
+            fprintf(file, (j == 0) ? "" : ", ");
+            write_json_string(file, param.key);
+            fprintf(file, ": ");
+            if (param.is_number) fprintf(file, "%s", param.value.c_str());
+            else write_json_string(file, param.value);
+        }
+        fprintf(file, "},\n");
+        fprintf(file, "      \"iterations\": %zu,\n", result.n_iterations);
+        fprintf(file, "      \"median_ns\": %.3f,\n", result.median_ns);
+        fprintf(file, "      \"min_ns\": %.3f", result.min_ns);
+        if (result.n_samples > 0.0) {
+            fprintf(file, ",\n      \"samples\": %g,\n", result.n_samples);
+            fprintf(file, "      \"voices\": %g,\n", result.n_voices);
+            fprintf(file, "      \"ns_per_sample\": %.4f,\n", result.median_ns / result.n_samples);
+            fprintf(file, "      \"ns_per_sample_per_voice\": %.4f",
+                    result.median_ns / result.n_samples / std::max(result.n_voices, 1.0));
+        }
+        if (result.n_items > 0.0) {
+            fprintf(file, ",\n      \"items\": %g,\n", result.n_items);
+            fprintf(file, "      \"item\": \"%s\",\n", result.item);
+            fprintf(file, "      \"ns_per_item\": %.4f", result.median_ns / result.n_items);
+        }
+        fprintf(file, "\n    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) options.output_path = argv[++i];
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) options.filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) options.min_time = atof(argv[++i]);
+        else if (strcmp(argv[i], "--scalar") == 0) options.scalar_kernels = true;
+    }
+
+    // Same floating point environment as the audio threads, so decaying envelopes don't hit subnormals
+    Realtime::flush_denormals();
+    const char* kernels = options.scalar_kernels ? OscKernels::scalar().name : OscKernels::best().name;
+
+    bench_wav_osc();
+    bench_vol_env();
+    bench_level_meter();
+    bench_midi_dispatch();
+    bench_scene_view();
+    bench_vertex_generation();
+
+    FILE* file = stdout;
+    if (options.output_path != nullptr) {
+        file = fopen(options.output_path, "w");
+        if (file == nullptr) {
+            LOG(Error, "Could not open \"%s\" for writing", options.output_path);
+            return 1;
+        }
+    }
+    write_json(file, kernels);
+    if (file != stdout) fclose(file);
+    return 0;
+}
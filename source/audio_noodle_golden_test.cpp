@@ -0,0 +1,295 @@
+// Golden audio regression test. Renders scripted MIDI through the headless engine and compares the result with reference
+// renders, sample by sample and by their spectra, so optimizations that change the output beyond the tolerances get caught.
+//
+// AudioNoodlesGoldenTest --references <dir> [--update] [--filter <substring>] [--output <dir>]
+//
+// --update writes the current renders as the new references, --output writes the renders that failed next to their
+// reference name, for listening. Exits with 1 if any comparison failed or a reference is missing.
+
+#include "fft.hpp"
+#include "log.hpp"
+#include "midi.hpp"
+#include "mixer.hpp"
+#include "parameters.hpp"
+#include "session.hpp"
+#include "wav_reader.hpp"
+#include "wav_writer.hpp"
+#include "processors/wav_osc.hpp"
+#include "processors/wavetable_osc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr double golden_sample_rate = 44100.0;
+
+// Tolerances. Reordering float math (SIMD, FMA) moves samples by a few ULP, which stays far inside these, while a changed
+// envelope, pitch or wave shape doesn't.
+constexpr double max_abs_error_limit = 1e-3;
+constexpr double min_snr_db          = 80.0;
+constexpr double max_spectral_db     = 1.0;   // Worst bin
+constexpr double max_spectral_rms_db = 0.25;  // Over all bins
+constexpr double spectral_floor_db   = -80.0; // Bins this far below the loudest one are ignored, they're mostly rounding
+constexpr size_t spectrum_size       = 4096;
+
+struct ScriptEvent {
+    double time_sec;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+};
+
+ScriptEvent note_on(double time_sec, uint8_t key, uint8_t velocity = 100) { return {time_sec, 0x90, key, velocity}; }
+ScriptEvent note_off(double time_sec, uint8_t key) { return {time_sec, 0x80, key, 0}; }
+ScriptEvent pitch_wheel(double time_sec, uint16_t value) {
+    return {time_sec, 0xE0, (uint8_t)(value & 0x7F), (uint8_t)(value >> 7)};
+}
+
+struct GoldenCase {
+    const char* name;
+    double length_sec;
+    size_t block_size;
+    size_t oversampling;
+    std::function<std::shared_ptr<Processor>()> create_processor;
+    std::vector<ScriptEvent> events; // In chronological order
+};
+
+struct Comparison {
+    double max_abs_error   = 0.0;
+    double snr_db          = 0.0; // Reference power over error power
+    double spectral_max_db = 0.0; // Largest difference between the average magnitude spectra
+    double spectral_rms_db = 0.0;
+};
+
+struct TestOptions {
+    const char* references = "test_data/golden";
+    const char* output     = nullptr;
+    const char* filter     = nullptr;
+    bool update            = false;
+};
+
+std::shared_ptr<Processor> make_wav_osc(WaveType wave_type, int unison_count, size_t max_polyphony = 256) {
+    auto osc            = std::make_shared<WavOsc>(max_polyphony);
+    const auto& handles = osc->param_handles;
+    Params::set(handles.wave_type, (double)wave_type - 1.0);
+    Params::set(handles.unison_count, (double)unison_count);
+    Params::set(handles.adsr_sustain, 0.6);
+    return osc;
+}
+
+std::vector<GoldenCase> golden_cases() {
+    std::vector<GoldenCase> cases;
+
+    cases.push_back({
+        "sine_chord", 3.0, 512, 1, []() { return make_wav_osc(WaveType::sine, 1); },
+        {note_on(0.1, 60), note_on(0.1, 64), note_on(0.1, 67), note_off(2.0, 60), note_off(2.0, 64), note_off(2.0, 67)},
+    });
+
+    GoldenCase square_arpeggio = {"square_unison", 3.0, 256, 1, []() { return make_wav_osc(WaveType::square, 4); }, {}};
+    for (int i = 0; i < 8; ++i) {
+        square_arpeggio.events.push_back(note_on(0.1 + 0.25 * i, (uint8_t)(48 + 4 * (i % 4))));
+        square_arpeggio.events.push_back(note_off(0.3 + 0.25 * i, (uint8_t)(48 + 4 * (i % 4))));
+    }
+    cases.push_back(square_arpeggio);
+
+    cases.push_back({
+        "triangle_pitch_bend", 3.0, 128, 1, []() { return make_wav_osc(WaveType::triangle, 1); },
+        {note_on(0.1, 57), pitch_wheel(0.5, 12288), pitch_wheel(1.0, 16383), pitch_wheel(1.5, 0), pitch_wheel(2.0, 8192),
+         note_off(2.5, 57)},
+    });
+
+    GoldenCase supersaw = {"sawtooth_supersaw", 3.0, 64, 1, []() { return make_wav_osc(WaveType::sawtooth, 9); }, {}};
+    for (int i = 0; i < 8; ++i) {
+        supersaw.events.push_back(note_on(0.1 + 0.3 * i, (uint8_t)(45 + 2 * i), (uint8_t)(60 + 8 * i)));
+        supersaw.events.push_back(note_off(0.25 + 0.3 * i, (uint8_t)(45 + 2 * i)));
+    }
+    cases.push_back(supersaw);
+
+    GoldenCase noise_hits = {"noise_hits", 2.5, 512, 1, []() { return make_wav_osc(WaveType::noise, 1); }, {}};
+    for (int i = 0; i < 6; ++i) {
+        noise_hits.events.push_back(note_on(0.1 + 0.3 * i, 60));
+        noise_hits.events.push_back(note_off(0.2 + 0.3 * i, 60));
+    }
+    cases.push_back(noise_hits);
+
+    // More notes than voices, so the allocator has to steal and fade out voices
+    GoldenCase stealing = {"voice_stealing", 3.0, 256, 1, []() { return make_wav_osc(WaveType::sawtooth, 1, 4); }, {}};
+    for (int i = 0; i < 8; ++i) {
+        stealing.events.push_back(note_on(0.1 + 0.1 * i, (uint8_t)(60 + i)));
+    }
+    for (int i = 0; i < 8; ++i) {
+        stealing.events.push_back(note_off(2.0, (uint8_t)(60 + i)));
+    }
+    cases.push_back(stealing);
+
+    cases.push_back({
+        "wavetable_chord", 3.0, 512, 1, []() { return std::make_shared<WavetableOsc>(); },
+        {note_on(0.1, 48), note_on(0.1, 55), note_on(0.1, 64), note_off(2.0, 48), note_off(2.0, 55), note_off(2.0, 64)},
+    });
+
+    cases.push_back({
+        "sawtooth_oversampled", 3.0, 512, 2, []() { return make_wav_osc(WaveType::sawtooth, 4); },
+        {note_on(0.1, 84), note_on(0.6, 96), note_off(1.5, 84), note_off(2.0, 96)},
+    });
+
+    return cases;
+}
+
+// Render a case through the mixer, with its events dispatched on their exact sample. Every case starts from a freshly
+// prepared mixer, so the master bus' limiter and delay line don't carry over from the case before it, and a case renders
+// the same on its own as in a full run.
+bool render_case(const GoldenCase& test, const AudioConfig& config, std::vector<float>& output) {
+    if (!Mixer::set_audio_config(config)) return false;
+    Session::add_track(std::make_shared<Track>(test.create_processor(), test.oversampling));
+
+    size_t next_event          = 0;
+    const auto dispatch_events = [&](uint64_t block_offset, size_t n_frames) {
+        for (; next_event < test.events.size(); ++next_event) {
+            const ScriptEvent& event = test.events[next_event];
+            const uint64_t position  = (uint64_t)llround(event.time_sec * golden_sample_rate);
+            if (position >= block_offset + n_frames) break;
+
+            Midi::MidiMessage message{};
+            message.status = event.status;
+            message.data1  = event.data1;
+            message.data2  = event.data2;
+            Midi::dispatch(message, Mixer::block_start_sample() + (position - std::min(position, block_offset)));
+        }
+    };
+    const size_t n_frames = (size_t)(test.length_sec * golden_sample_rate);
+    const bool success    = Mixer::render_offline(output, n_frames, test.block_size, dispatch_events);
+
+    while (!Session::tracks().empty()) Session::remove_track(0);
+    Mixer::update();
+    return success;
+}
+
+// Average power spectrum of one channel, Hann windowed, with half overlapping frames
+std::vector<double> power_spectrum(const std::vector<float>& samples, size_t channel) {
+    const size_t n_frames = samples.size() / 2;
+    std::vector<double> power(spectrum_size / 2 + 1, 0.0);
+    std::vector<std::complex<float>> frame(spectrum_size);
+
+    for (size_t start = 0; start + spectrum_size <= n_frames; start += spectrum_size / 2) {
+        for (size_t i = 0; i < spectrum_size; ++i) {
+            const double window = 0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)spectrum_size);
+            frame[i]            = {(float)(samples[2 * (start + i) + channel] * window), 0.0f};
+        }
+        FFT::forward(frame.data(), spectrum_size);
+        for (size_t bin = 0; bin < power.size(); ++bin) {
+            power[bin] += (double)std::norm(frame[bin]);
+        }
+    }
+    return power;
+}
+
+Comparison compare(const std::vector<float>& reference, const std::vector<float>& actual) {
+    Comparison result;
+    double signal_power = 0.0;
+    double error_power  = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const double error   = (double)actual[i] - (double)reference[i];
+        result.max_abs_error = std::max(result.max_abs_error, fabs(error));
+        signal_power += (double)reference[i] * (double)reference[i];
+        error_power += error * error;
+    }
+    result.snr_db = (error_power > 0.0) ? 10.0 * log10(signal_power / error_power) : INFINITY;
+
+    double sum_squares = 0.0;
+    size_t n_bins      = 0;
+    for (size_t channel = 0; channel < 2; ++channel) {
+        const std::vector<double> reference_power = power_spectrum(reference, channel);
+        const std::vector<double> actual_power    = power_spectrum(actual, channel);
+
+        const double peak  = *std::max_element(reference_power.begin(), reference_power.end());
+        const double floor = peak * pow(10.0, spectral_floor_db / 10.0);
+
+        for (size_t bin = 0; bin < reference_power.size(); ++bin) {
+            if (reference_power[bin] <= floor && actual_power[bin] <= floor) continue;
+            const double difference_db =
+                10.0 * log10(std::max(actual_power[bin], floor) / std::max(reference_power[bin], floor));
+            result.spectral_max_db = std::max(result.spectral_max_db, fabs(difference_db));
+            sum_squares += difference_db * difference_db;
+            ++n_bins;
+        }
+    }
+    result.spectral_rms_db = (n_bins > 0) ? sqrt(sum_squares / (double)n_bins) : 0.0;
+    return result;
+}
+
+bool write_wav(const std::string& path, const std::vector<float>& samples) {
+    WavWriter writer;
+    if (!writer.open(path.c_str(), (uint32_t)golden_sample_rate, 2)) return false;
+    writer.write(samples.data(), samples.size() / 2);
+    writer.close();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    TestOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--references") == 0 && i + 1 < argc) options.references = argv[++i];
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) options.output = argv[++i];
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) options.filter = argv[++i];
+        else if (strcmp(argv[i], "--update") == 0) options.update = true;
+    }
+
+    AudioConfig config;
+    config.sample_rate = golden_sample_rate;
+
+    size_t n_failed  = 0;
+    size_t n_missing = 0;
+    for (const GoldenCase& test: golden_cases()) {
+        if (options.filter != nullptr && strstr(test.name, options.filter) == nullptr) continue;
+
+        std::vector<float> actual;
+        if (!render_case(test, config, actual)) return 1;
+
+        const std::string reference_path = std::string(options.references) + "/" + test.name + ".wav";
+        if (options.update) {
+            std::filesystem::create_directories(options.references);
+            if (!write_wav(reference_path, actual)) return 1;
+            printf("%-24s updated\n", test.name);
+            continue;
+        }
+
+        WavReader reference;
+        if (!std::filesystem::exists(reference_path) || !reference.open(reference_path.c_str())) {
+            printf("%-24s FAILED, missing reference \"%s\"\n", test.name, reference_path.c_str());
+            ++n_missing;
+            continue;
+        }
+        if (reference.sample_rate != (uint32_t)golden_sample_rate || reference.n_channels != 2 ||
+            reference.samples.size() != actual.size()) {
+            printf("%-24s FAILED, reference has a different format or length\n", test.name);
+            ++n_failed;
+            continue;
+        }
+
+        const Comparison result = compare(reference.samples, actual);
+        const bool passed       = result.max_abs_error <= max_abs_error_limit && result.snr_db >= min_snr_db &&
+                            result.spectral_max_db <= max_spectral_db && result.spectral_rms_db <= max_spectral_rms_db;
+        printf("%-24s %s  max error %.2e, SNR %6.1f dB, spectrum max %.3f dB, rms %.3f dB\n", test.name,
+               passed ? "ok    " : "FAILED", result.max_abs_error, result.snr_db, result.spectral_max_db,
+               result.spectral_rms_db);
+        if (passed) continue;
+
+        ++n_failed;
+        if (options.output != nullptr) {
+            std::filesystem::create_directories(options.output);
+            write_wav(std::string(options.output) + "/" + test.name + ".wav", actual);
+        }
+    }
+
+    if (n_missing > 0) {
+        LOG(Error, "%zu reference(s) missing, run with --update on a known good build to create them", n_missing);
+    }
+    return (n_failed > 0 || n_missing > 0) ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+// Voice budget test. Plays bursts of notes through voice allocators that share the global voice budget, and checks that
+// the voices that are still sounding never go over it, and that voices fading out after a steal don't make new notes
+// steal more than they need to.
+//
+// AudioNoodlesVoiceBudgetTest. Exits with 1 if any check failed.
+
+#include "voice_allocator.hpp"
+
+#include <cstdio>
+#include <vector>
+
+constexpr size_t test_budget    = 8;
+constexpr size_t test_polyphony = 256;
+
+// One processor's worth of voice state, like the oscillators keep it
+struct TestVoices {
+    VoiceAllocator allocator;
+    std::vector<VolEnv> vol_envs;
+    std::vector<uint8_t> keys;
+
+    TestVoices() {
+        this->allocator.init(test_polyphony, 44100.0);
+        this->vol_envs.resize(this->allocator.pool_size());
+        this->keys.resize(this->allocator.pool_size());
+    }
+
+    uint32_t note_on(uint8_t key) {
+        this->allocator.begin_note();
+        const uint32_t voice = this->allocator.allocate(key, StealPolicy::oldest, this->vol_envs.data(), this->keys.data());
+        if (voice != VoiceAllocator::none) {
+            this->keys[voice]           = key;
+            this->vol_envs[voice].stage = VolEnvStage::sustain;
+        }
+        return voice;
+    }
+
+    // Release the first voice that isn't fading out, as if its note had finished its release
+    void finish_note() {
+        for (size_t i = 0; i < this->allocator.active_voices.size(); ++i) {
+            if (this->allocator.fading[this->allocator.active_voices[i]]) continue;
+            this->allocator.release(i);
+            return;
+        }
+    }
+};
+
+size_t n_failed = 0;
+
+void check(bool passed, const char* name, const char* what) {
+    if (passed) return;
+    printf("%-24s FAILED, %s\n", name, what);
+    ++n_failed;
+}
+
+// Two processors take turns starting notes, far more than the budget allows
+void test_burst() {
+    const char* name = "burst";
+    TestVoices a;
+    TestVoices b;
+    for (size_t i = 0; i < 64; ++i) {
+        TestVoices& voices = (i % 2 == 0) ? a : b;
+        voices.note_on((uint8_t)(36 + i));
+        check(VoiceAllocator::n_global_sounding_voices() <= test_budget, name, "more voices sounding than the budget");
+        check(voices.allocator.n_active() - voices.allocator.n_fading <= test_polyphony, name, "over the polyphony");
+    }
+    check(VoiceAllocator::n_global_sounding_voices() == test_budget, name, "the budget isn't fully used after the burst");
+    printf("%-24s %zu sounding, %zu fading\n", name, VoiceAllocator::n_global_sounding_voices(),
+           VoiceAllocator::n_global_voices() - VoiceAllocator::n_global_sounding_voices());
+}
+
+// Once a note ends there is room again, so the next note shouldn't steal, even while a stolen voice is still fading out
+void test_no_extra_steal() {
+    const char* name = "no_extra_steal";
+    TestVoices voices;
+    for (size_t i = 0; i < test_budget + 1; ++i) {
+        voices.note_on((uint8_t)(48 + i));
+    }
+    check(voices.allocator.n_fading == 1, name, "filling the budget plus one should steal exactly one voice");
+
+    voices.finish_note();
+    voices.note_on(72);
+    check(voices.allocator.n_fading == 1, name, "a note stole a voice while the budget had room");
+    check(VoiceAllocator::n_global_sounding_voices() == test_budget, name, "the budget isn't fully used");
+    printf("%-24s %zu sounding, %zu fading\n", name, VoiceAllocator::n_global_sounding_voices(), voices.allocator.n_fading);
+}
+
+int main() {
+    const size_t previous_budget = VoiceAllocator::global_budget();
+    VoiceAllocator::set_global_budget(test_budget);
+
+    test_burst();
+    check(VoiceAllocator::n_global_voices() == 0, "cleanup", "voices left over after the allocators were destroyed");
+    test_no_extra_steal();
+    check(VoiceAllocator::n_global_voices() == 0, "cleanup", "voices left over after the allocators were destroyed");
+
+    VoiceAllocator::set_global_budget(previous_budget);
+    return (n_failed > 0) ? 1 : 0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <cstdint>
+#include <chrono>
+#include <cmath>
 
 #ifndef M_PI
     #define M_PI   3.14159265358979323846
@@ -32,5 +34,17 @@ namespace Common {
         0x0fff,
     };
 
+    // Monotonic clock in nanoseconds, used to timestamp events across threads
+    inline int64_t time_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Frequency in Hz of a (fractional) MIDI note
+    inline double note_frequency(double note) {
+        const double key_relative_to_a4 = note - 69.0;      // nice
+        return 440.0 * pow(2.0, key_relative_to_a4 / 12.0); // todo: non-440 hz tuning, microtonality, mod vibrato
+    }
+
 #define TODO()
 } // namespace Common
@@ -0,0 +1,68 @@
+#include "fft.hpp"
+#include "common.hpp"
+#include <cmath>
+#include <utility>
+
+namespace FFT {
+    void transform(std::complex<float>* data, size_t n_samples, double direction) {
+        // Bit-reversal permutation
+        for (size_t i = 1, j = 0; i < n_samples; ++i) {
+            size_t bit = n_samples >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) std::swap(data[i], data[j]);
+        }
+
+        // Butterflies, the twiddle factors are stepped in double precision to keep the error down on large sizes
+        for (size_t length = 2; length <= n_samples; length <<= 1) {
+            const double angle = direction * 2.0 * M_PI / (double)length;
+            const std::complex<double> w_step(cos(angle), sin(angle));
+            for (size_t start = 0; start < n_samples; start += length) {
+                std::complex<double> w = 1.0;
+                for (size_t k = 0; k < length / 2; ++k) {
+                    const std::complex<float> even = data[start + k];
+                    const std::complex<float> odd  = data[start + k + length / 2] * std::complex<float>(w);
+                    data[start + k]                = even + odd;
+                    data[start + k + length / 2]   = even - odd;
+                    w *= w_step;
+                }
+            }
+        }
+    }
+
+    void forward(std::complex<float>* data, size_t n_samples) { transform(data, n_samples, -1.0); }
+
+    void forward_real(const float* input, std::complex<float>* output, size_t n_samples) {
+        // Even samples go in the real part, odd ones in the imaginary part
+        const size_t half = n_samples / 2;
+        for (size_t i = 0; i < half; ++i) {
+            output[i] = {input[2 * i + 0], input[2 * i + 1]};
+        }
+        forward(output, half);
+
+        // Untangle the spectra of the even and odd samples, E[k] = (Z[k] + conj(Z[half - k])) / 2 and
+        // O[k] = (Z[k] - conj(Z[half - k])) / 2i, then X[k] = E[k] + w^k * O[k]. Bins k and half - k are built from the same
+        // pair of inputs, so they're done together to work in place.
+        const std::complex<float> dc = output[0];
+        output[0]                    = {dc.real() + dc.imag(), 0.0f};
+        output[half]                 = {dc.real() - dc.imag(), 0.0f};
+        for (size_t k = 1; k <= half / 2; ++k) {
+            const size_t j                 = half - k;
+            const std::complex<float> zk   = output[k];
+            const std::complex<float> zj   = std::conj(output[j]);
+            const std::complex<float> even = (zk + zj) * 0.5f;
+            const std::complex<float> odd  = (zk - zj) * std::complex<float>(0.0f, -0.5f);
+            const double angle             = -2.0 * M_PI * (double)k / (double)n_samples;
+            const std::complex<float> w_k((float)cos(angle), (float)sin(angle));
+            // w^j = -conj(w^k), since j = n_samples / 2 - k
+            output[k] = even + w_k * odd;
+            output[j] = std::conj(even) - std::conj(w_k) * std::conj(odd);
+        }
+    }
+
+    void inverse(std::complex<float>* data, size_t n_samples) {
+        transform(data, n_samples, 1.0);
+        const float scale = 1.0f / (float)n_samples;
+        for (size_t i = 0; i < n_samples; ++i) data[i] *= scale;
+    }
+} // namespace FFT
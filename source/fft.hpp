@@ -0,0 +1,13 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+
+// In-place radix-2 FFT. `n_samples` has to be a power of two.
+namespace FFT {
+    void forward(std::complex<float>* data, size_t n_samples);
+    // Inverse transform, including the 1/n scaling, so inverse(forward(x)) == x
+    void inverse(std::complex<float>* data, size_t n_samples);
+    // Forward transform of real input, done as a complex transform of half the size. `output` gets the n_samples / 2 + 1
+    // bins from DC up to Nyquist, the rest of the spectrum is their mirror image. `n_samples` has to be at least 2.
+    void forward_real(const float* input, std::complex<float>* output, size_t n_samples);
+} // namespace FFT
@@ -188,6 +188,12 @@ namespace Gfx {
         device->end_frame();
     }
 
+    void discard_frame() {
+        render_queue.clear();
+        curr_render_info.vertices_to_render.clear();
+        curr_render_info.type = RenderInfoType::None;
+    }
+
     void push_clip_rect(glm::ivec2 top_left, glm::ivec2 size) {
         if (curr_render_info.scissor_rect_top_left != top_left) render_info_dirty = true;
         if (curr_render_info.scissor_rect_size != size) render_info_dirty = true;
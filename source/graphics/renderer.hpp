@@ -85,6 +85,9 @@ namespace Gfx {
     // Rendering
     void begin_frame();
     void end_frame();
+    // Throw away everything queued since begin_frame() instead of drawing it. This doesn't touch the device, so it also works
+    // without a window.
+    void discard_frame();
     void push_clip_rect(glm::ivec2 top_left = {0.0f, 0.0f}, glm::ivec2 size = {99999.0f, 99999.0f});
     void pop_clip_rect();
     void set_viewport(glm::ivec2 top_left = {0.0f, 0.0f}, glm::ivec2 size = {99999.0f, 99999.0f});
@@ -0,0 +1,105 @@
+#include "level_meter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LEVEL_METER_SSE2
+    #include <emmintrin.h>
+#endif
+
+// Largest absolute value and sum of squares of each channel of an interleaved stereo block, in a single pass
+static void measure_block(const float* buffer, size_t n_frames, float peak[2], float sum_squares[2]) {
+    peak[0]        = 0.0f;
+    peak[1]        = 0.0f;
+    sum_squares[0] = 0.0f;
+    sum_squares[1] = 0.0f;
+
+    size_t i = 0;
+#ifdef LEVEL_METER_SSE2
+    // Lanes 0 and 2 hold the left channel, 1 and 3 the right one. Two sums, so the adds don't all wait on each other.
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 max            = _mm_setzero_ps();
+    __m128 sum_a          = _mm_setzero_ps();
+    __m128 sum_b          = _mm_setzero_ps();
+    for (; i + 4 <= n_frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(buffer + 2 * i + 0);
+        const __m128 b = _mm_loadu_ps(buffer + 2 * i + 4);
+        max            = _mm_max_ps(max, _mm_max_ps(_mm_and_ps(a, abs_mask), _mm_and_ps(b, abs_mask)));
+        sum_a          = _mm_add_ps(sum_a, _mm_mul_ps(a, a));
+        sum_b          = _mm_add_ps(sum_b, _mm_mul_ps(b, b));
+    }
+    __m128 sum = _mm_add_ps(sum_a, sum_b);
+    max        = _mm_max_ps(max, _mm_movehl_ps(max, max));
+    sum        = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    float lanes[4];
+    _mm_storeu_ps(lanes, max);
+    peak[0] = lanes[0];
+    peak[1] = lanes[1];
+    _mm_storeu_ps(lanes, sum);
+    sum_squares[0] = lanes[0];
+    sum_squares[1] = lanes[1];
+#endif
+    for (; i < n_frames; ++i) {
+        for (size_t channel = 0; channel < 2; ++channel) {
+            const float sample = buffer[2 * i + channel];
+            peak[channel]      = std::max(peak[channel], fabsf(sample));
+            sum_squares[channel] += sample * sample;
+        }
+    }
+}
+
+void LevelMeter::process(const float* buffer, size_t n_frames, double sample_rate) {
+    if (n_frames == 0 || sample_rate <= 0.0) return;
+
+    float block_peak[2];
+    float block_sum_squares[2];
+    measure_block(buffer, n_frames, block_peak, block_sum_squares);
+
+    // The ballistics are worked out per block rather than per sample, which is plenty for something that gets drawn
+    const double block_sec = (double)n_frames / sample_rate;
+    const float falloff    = (float)pow(10.0, -peak_falloff_db * block_sec / 20.0);
+    const double rms_coef  = 1.0 - exp(-block_sec / rms_window_sec);
+    for (size_t channel = 0; channel < 2; ++channel) {
+        const float new_peak      = block_peak[channel];
+        this->peak_state[channel] = std::max(new_peak, this->peak_state[channel] * falloff);
+
+        const double block_mean_square = (double)block_sum_squares[channel] / (double)n_frames;
+        this->mean_square[channel] += (block_mean_square - this->mean_square[channel]) * rms_coef;
+
+        // A new peak restarts the hold, after that the held value follows the falling peak back down
+        if (new_peak >= this->peak_hold_state[channel]) {
+            this->peak_hold_state[channel] = new_peak;
+            this->hold_left_sec[channel]   = peak_hold_sec;
+        } else if (this->hold_left_sec[channel] > 0.0) {
+            this->hold_left_sec[channel] -= block_sec;
+        } else {
+            this->peak_hold_state[channel] = this->peak_state[channel];
+        }
+    }
+
+    const uint32_t sequence = this->sequence.load(std::memory_order_relaxed);
+    this->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t channel = 0; channel < 2; ++channel) {
+        this->peak[channel].store(this->peak_state[channel], std::memory_order_relaxed);
+        this->rms[channel].store((float)sqrt(this->mean_square[channel]), std::memory_order_relaxed);
+        this->peak_hold[channel].store(this->peak_hold_state[channel], std::memory_order_relaxed);
+    }
+    this->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+LevelMeter::Snapshot LevelMeter::snapshot() const {
+    Snapshot snapshot;
+    uint32_t sequence_begin;
+    do {
+        sequence_begin = this->sequence.load(std::memory_order_acquire);
+        for (size_t channel = 0; channel < 2; ++channel) {
+            snapshot.peak[channel]      = this->peak[channel].load(std::memory_order_relaxed);
+            snapshot.rms[channel]       = this->rms[channel].load(std::memory_order_relaxed);
+            snapshot.peak_hold[channel] = this->peak_hold[channel].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence_begin & 1) || sequence_begin != this->sequence.load(std::memory_order_relaxed));
+    return snapshot;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Peak and RMS level of an interleaved stereo signal. The audio thread measures every block it renders and publishes the
+// result, which any other thread can read without locks. The peak falls off slowly instead of being replaced every block,
+// so a UI that only looks once per frame still sees every transient.
+struct LevelMeter {
+    static constexpr double rms_window_sec  = 0.3;  // Time constant of the RMS average
+    static constexpr double peak_falloff_db = 20.0; // Per second
+    static constexpr double peak_hold_sec   = 1.5;
+
+    // Linear amplitudes, left and right
+    struct Snapshot {
+        float peak[2]      = {};
+        float rms[2]       = {};
+        float peak_hold[2] = {};
+    };
+
+    // Only call this from one thread at a time
+    void process(const float* buffer, size_t n_frames, double sample_rate);
+    // Can be called from any thread
+    Snapshot snapshot() const;
+
+    // Seqlock: the sequence number is odd while the audio thread is writing
+    std::atomic<uint32_t> sequence = 0;
+    std::atomic<float> peak[2]{};
+    std::atomic<float> rms[2]{};
+    std::atomic<float> peak_hold[2]{};
+
+    // Only touched by the thread that calls process()
+    double mean_square[2]    = {};
+    double hold_left_sec[2]  = {};
+    float peak_state[2]      = {};
+    float peak_hold_state[2] = {};
+};
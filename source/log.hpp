@@ -1,3 +1,4 @@
+#pragma once
 namespace Log {
     enum class Level { Debug = 0, Info, Warning, Error, Fatal, Disabled };
 
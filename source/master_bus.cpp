@@ -0,0 +1,216 @@
+#include "master_bus.hpp"
+#include "common.hpp"
+#include "mixer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MASTER_BUS_SSE2
+    #include <emmintrin.h>
+#endif
+
+// Multiply every frame of interleaved stereo `input` by its own gain, `output` may point to `input`
+static void multiply_frames(float* output, const float* input, const float* gain, size_t n_frames) {
+    size_t i = 0;
+#ifdef MASTER_BUS_SSE2
+    for (; i + 4 <= n_frames; i += 4) {
+        const __m128 gains = _mm_loadu_ps(gain + i);
+        const __m128 lo    = _mm_unpacklo_ps(gains, gains); // g0 g0 g1 g1
+        const __m128 hi    = _mm_unpackhi_ps(gains, gains); // g2 g2 g3 g3
+        _mm_storeu_ps(output + 2 * i + 0, _mm_mul_ps(_mm_loadu_ps(input + 2 * i + 0), lo));
+        _mm_storeu_ps(output + 2 * i + 4, _mm_mul_ps(_mm_loadu_ps(input + 2 * i + 4), hi));
+    }
+#endif
+    for (; i < n_frames; ++i) {
+        output[2 * i + 0] = input[2 * i + 0] * gain[i];
+        output[2 * i + 1] = input[2 * i + 1] * gain[i];
+    }
+}
+
+// Rational approximation of tanh, which reaches exactly +-1 with a flat slope at +-3, so the curve has no corner there
+static void soft_clip(float* buffer, size_t n_samples) {
+    size_t i = 0;
+#ifdef MASTER_BUS_SSE2
+    const __m128 limit = _mm_set1_ps(3.0f);
+    const __m128 c27   = _mm_set1_ps(27.0f);
+    const __m128 c9    = _mm_set1_ps(9.0f);
+    for (; i + 4 <= n_samples; i += 4) {
+        const __m128 x  = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(buffer + i), limit), _mm_sub_ps(_mm_setzero_ps(), limit));
+        const __m128 x2 = _mm_mul_ps(x, x);
+        _mm_storeu_ps(buffer + i, _mm_div_ps(_mm_mul_ps(x, _mm_add_ps(c27, x2)), _mm_add_ps(c27, _mm_mul_ps(c9, x2))));
+    }
+#endif
+    for (; i < n_samples; ++i) {
+        const float x  = std::clamp(buffer[i], -3.0f, 3.0f);
+        const float x2 = x * x;
+        buffer[i]      = x * (27.0f + x2) / (27.0f + 9.0f * x2);
+    }
+}
+
+void MasterBus::prepare(double sample_rate) {
+    auto& handles = this->param_handles;
+    if (handles.volume == Params::invalid) {
+        handles.volume             = Params::create("master_volume", 0.8);
+        handles.limiter_enabled    = Params::create("master_limiter", 1.0);
+        handles.limiter_ceiling_db = Params::create("master_limiter_ceiling", -1.0);
+        handles.limiter_release_ms = Params::create("master_limiter_release", 100.0);
+        handles.soft_clip_enabled  = Params::create("master_soft_clip", 0.0);
+
+        // Blackman windowed sinc with its cutoff at the original Nyquist frequency, split into 4 phases. Every phase is
+        // normalized to unity gain at DC, so a constant signal reads as exactly its own level.
+        constexpr size_t n_taps  = 4 * interpolator_taps;
+        const double center      = (double)(n_taps - 1) / 2.0;
+        double phase_sums[4]     = {};
+        double prototype[n_taps] = {};
+        for (size_t i = 0; i < n_taps; ++i) {
+            const double x      = ((double)i - center) / 4.0;
+            const double sinc   = sin(M_PI * x) / (M_PI * x);
+            const double t      = ((double)i + 0.5) / (double)n_taps;
+            const double window = 0.42 - 0.5 * cos(2.0 * M_PI * t) + 0.08 * cos(4.0 * M_PI * t);
+            prototype[i]        = sinc * window;
+            phase_sums[i % 4] += prototype[i];
+        }
+        for (size_t tap = 0; tap < interpolator_taps; ++tap) {
+            for (size_t phase = 0; phase < 4; ++phase) {
+                this->interpolator_coefs[4 * tap + phase] = (float)(prototype[4 * tap + phase] / phase_sums[phase]);
+            }
+        }
+    }
+
+    this->sample_rate = sample_rate;
+    this->gain_smoothed.init(sample_rate, 0.05, SmoothingType::exponential);
+    const float volume = (float)Params::get(handles.volume);
+    this->gain_smoothed.snap(volume * volume);
+
+    // Phase p of the interpolator lands (4 * interpolator_taps - 1 - 2p) / 8 samples back, so all of them fall between
+    // the sample interpolator_taps / 2 back and the one after it, which is what the peaks get lined up with
+    this->lookahead = std::max((size_t)round(lookahead_sec * sample_rate), (size_t)1);
+    this->latency   = this->lookahead - 1 + interpolator_taps / 2;
+
+    this->gain_ramp.assign(Mixer::max_block_frames, 1.0f);
+    this->limiter_gain.assign(Mixer::max_block_frames, 1.0f);
+    this->peaks.assign(Mixer::max_block_frames, 0.0f);
+    for (auto& channel: this->detector_input) {
+        channel.assign(interpolator_taps - 1 + Mixer::max_block_frames, 0.0f);
+    }
+    this->delay_line.assign(2 * (this->latency + Mixer::max_block_frames), 0.0f);
+    this->hold_values.assign(this->lookahead + 1, 1.0f);
+    this->hold_positions.assign(this->lookahead + 1, 0);
+    this->hold_front = 0;
+    this->hold_back  = 0;
+    this->average_ring.assign(this->lookahead, 1.0f);
+    this->average_sum   = (double)this->lookahead;
+    this->release_gain  = 1.0f;
+    this->frame_counter = 0;
+}
+
+void MasterBus::process(float* buffer, size_t n_frames) {
+    assert(this->lookahead > 0 && "MasterBus::process() called before prepare()");
+    const auto& handles = this->param_handles;
+
+    // The volume is squared, the same curve the voices use for velocity
+    const float volume = (float)Params::get(handles.volume);
+    this->gain_smoothed.set_target(volume * volume);
+    this->gain_smoothed.fill(this->gain_ramp.data(), n_frames);
+    multiply_frames(buffer, buffer, this->gain_ramp.data(), n_frames);
+
+    constexpr size_t history = interpolator_taps - 1;
+    float* detector[2]       = {this->detector_input[0].data(), this->detector_input[1].data()};
+    float* gain              = this->limiter_gain.data();
+
+    if (Params::get(handles.limiter_enabled) >= 0.5) {
+        for (size_t i = 0; i < n_frames; ++i) {
+            detector[0][history + i] = buffer[2 * i + 0];
+            detector[1][history + i] = buffer[2 * i + 1];
+        }
+
+        // True peak of every frame, the largest of the 4 interpolated points after the delayed sample and the sample itself
+        const float* coefs = this->interpolator_coefs;
+        for (size_t i = 0; i < n_frames; ++i) {
+            const float* left  = detector[0] + history + i; // Newest sample, older ones at negative offsets
+            const float* right = detector[1] + history + i;
+            float peak         = std::max(fabsf(left[-(ptrdiff_t)interpolator_taps / 2]),
+                                          fabsf(right[-(ptrdiff_t)interpolator_taps / 2]));
+#ifdef MASTER_BUS_SSE2
+            __m128 left_sum  = _mm_setzero_ps();
+            __m128 right_sum = _mm_setzero_ps();
+            for (size_t tap = 0; tap < interpolator_taps; ++tap) {
+                const __m128 coef = _mm_loadu_ps(coefs + 4 * tap);
+                left_sum          = _mm_add_ps(left_sum, _mm_mul_ps(_mm_set1_ps(left[-(ptrdiff_t)tap]), coef));
+                right_sum         = _mm_add_ps(right_sum, _mm_mul_ps(_mm_set1_ps(right[-(ptrdiff_t)tap]), coef));
+            }
+            const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            __m128 max            = _mm_max_ps(_mm_and_ps(left_sum, abs_mask), _mm_and_ps(right_sum, abs_mask));
+            max                   = _mm_max_ps(max, _mm_shuffle_ps(max, max, _MM_SHUFFLE(1, 0, 3, 2)));
+            max                   = _mm_max_ps(max, _mm_shuffle_ps(max, max, _MM_SHUFFLE(2, 3, 0, 1)));
+            peak                  = std::max(peak, _mm_cvtss_f32(max));
+#else
+            for (size_t phase = 0; phase < 4; ++phase) {
+                float left_sum  = 0.0f;
+                float right_sum = 0.0f;
+                for (size_t tap = 0; tap < interpolator_taps; ++tap) {
+                    left_sum += left[-(ptrdiff_t)tap] * coefs[4 * tap + phase];
+                    right_sum += right[-(ptrdiff_t)tap] * coefs[4 * tap + phase];
+                }
+                peak = std::max(peak, std::max(fabsf(left_sum), fabsf(right_sum)));
+            }
+#endif
+            this->peaks[i] = peak;
+        }
+        for (auto* channel: detector) {
+            memmove(channel, channel + n_frames, sizeof(float) * history);
+        }
+
+        // Hold the lowest required gain for the length of the lookahead, let it recover at the release rate, and average it
+        // over the lookahead. The average is never above any of the values it's made of, so it is down to the required gain
+        // by the time the peak leaves the delay line, and it gets there in a straight line instead of a jump.
+        const float ceiling      = (float)pow(10.0, Params::get(handles.limiter_ceiling_db) / 20.0);
+        const double release_sec = std::max(Params::get(handles.limiter_release_ms), 1.0) / 1000.0;
+        const float release_coef = (float)(1.0 - exp(-1.0 / (release_sec * this->sample_rate)));
+        const size_t capacity    = this->hold_values.size();
+        for (size_t i = 0; i < n_frames; ++i) {
+            const float required = (this->peaks[i] > ceiling) ? (ceiling / this->peaks[i]) : 1.0f;
+
+            while (this->hold_back != this->hold_front && this->hold_values[(this->hold_back - 1) % capacity] >= required) {
+                --this->hold_back;
+            }
+            this->hold_values[this->hold_back % capacity]    = required;
+            this->hold_positions[this->hold_back % capacity] = this->frame_counter;
+            ++this->hold_back;
+            while (this->hold_positions[this->hold_front % capacity] + this->lookahead <= this->frame_counter) {
+                ++this->hold_front;
+            }
+            const float held = this->hold_values[this->hold_front % capacity];
+
+            if (held < this->release_gain) this->release_gain = held;
+            else this->release_gain += (held - this->release_gain) * release_coef;
+
+            float& oldest = this->average_ring[this->frame_counter % this->lookahead];
+            this->average_sum += (double)this->release_gain - (double)oldest;
+            oldest  = this->release_gain;
+            gain[i] = std::min((float)(this->average_sum / (double)this->lookahead), 1.0f);
+            ++this->frame_counter;
+        }
+    } else {
+        // Start from a clean slate when the limiter gets turned back on
+        std::fill(gain, gain + n_frames, 1.0f);
+        for (auto* channel: detector) {
+            std::fill(channel, channel + history, 0.0f);
+        }
+        std::fill(this->average_ring.begin(), this->average_ring.end(), 1.0f);
+        this->average_sum  = (double)this->lookahead;
+        this->release_gain = 1.0f;
+        this->hold_front   = this->hold_back;
+    }
+
+    // The delay stays in even with the limiter off, so turning it on or off doesn't make the output jump in time
+    float* delayed = this->delay_line.data();
+    memcpy(delayed + 2 * this->latency, buffer, sizeof(float) * 2 * n_frames);
+    multiply_frames(buffer, delayed, gain, n_frames);
+    memmove(delayed, delayed + 2 * n_frames, sizeof(float) * 2 * this->latency);
+
+    if (Params::get(handles.soft_clip_enabled) >= 0.5) soft_clip(buffer, 2 * n_frames);
+}
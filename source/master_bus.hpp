@@ -0,0 +1,58 @@
+#pragma once
+#include "parameters.hpp"
+#include "smoothed_value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Last stage before the output device, processing the interleaved stereo output of the graph in place: the master volume,
+// a lookahead limiter that keeps the true peak level below its ceiling, and an optional soft clipper.
+//
+// The limiter estimates the peaks between samples by upsampling 4x, works out the gain each frame needs, and smooths that
+// into an envelope which reaches the required gain right as the peak comes out of the lookahead delay. The delay is always
+// there, so toggling the limiter doesn't shift the output in time.
+struct MasterBus {
+    static constexpr size_t interpolator_taps = 12; // Per phase of the 4x true peak interpolator
+    static constexpr double lookahead_sec     = 0.0015;
+
+    // Not real-time safe. Creates the parameters on the first call, sizes the buffers for `sample_rate` and resets all state.
+    void prepare(double sample_rate);
+    // Only after prepare()
+    void process(float* buffer, size_t n_frames);
+    // How far the output is delayed, in samples
+    double latency_samples() const { return (double)this->latency; }
+
+    struct {
+        Params::Handle volume             = Params::invalid;
+        Params::Handle limiter_enabled    = Params::invalid;
+        Params::Handle limiter_ceiling_db = Params::invalid;
+        Params::Handle limiter_release_ms = Params::invalid;
+        Params::Handle soft_clip_enabled  = Params::invalid;
+    } param_handles;
+
+    SmoothedValue gain_smoothed;
+    std::vector<float> gain_ramp;
+    std::vector<float> limiter_gain; // Per frame of the current block
+    std::vector<float> peaks;        // True peak of each frame in the current block
+    // Per channel, the current block preceded by the history the interpolator needs
+    std::vector<float> detector_input[2];
+    // Interleaved, the current block preceded by `latency` frames of history
+    std::vector<float> delay_line;
+    // The interpolator's coefficients, with the 4 phases of each tap next to each other
+    float interpolator_coefs[interpolator_taps * 4] = {};
+
+    // Sliding minimum of the required gain over the lookahead window, kept as a ring of increasing values
+    std::vector<float> hold_values;
+    std::vector<uint64_t> hold_positions;
+    size_t hold_front = 0;
+    size_t hold_back  = 0;
+    // Moving average over the lookahead window, which turns the held gain into a smooth ramp
+    std::vector<float> average_ring;
+    double average_sum = 0.0;
+
+    float release_gain     = 1.0f;
+    size_t lookahead       = 0; // Frames
+    size_t latency         = 0; // Frames, the lookahead plus the interpolator's delay
+    uint64_t frame_counter = 0;
+    double sample_rate     = 0.0;
+};
@@ -1,24 +1,44 @@
 #include "midi.hpp"
 #include "log.hpp"
+#include "mixer.hpp"
+#include "common.hpp"
 #include "session.hpp"
+#include "spsc_ring.hpp"
 #include <RtMidi.h>
-#include <mutex>
 
 namespace Midi {
     std::shared_ptr<RtMidiIn> midi_in;
-    std::vector<MidiMessage> message_queue;
-    std::mutex mutex;
+    // Written by the RtMidi thread, read by the audio thread
+    SpscRing<MidiMessage, 4096> message_queue;
+    // Copies of the incoming messages for the debug log, written by the RtMidi thread and logged by update(). Logging locks,
+    // so the driver thread can't do it itself. When this overflows the trace just misses a few messages.
+    SpscRing<MidiMessage, 1024> trace_queue;
+    uint64_t n_overflows_reported = 0;
+    int64_t prev_timestamp_ns     = 0; // Only touched by the RtMidi thread
+
+    // RtMidi measures `delta_time` (time since the previous message) closer to the driver than we can, so consecutive
+    // messages are timestamped relative to each other using it. The timestamp is re-anchored to the clock whenever the two
+    // drift apart, e.g. for the first message after a pause.
+    int64_t message_timestamp(const double delta_time) {
+        constexpr int64_t max_drift_ns = 2'000'000;
+        const int64_t now_ns           = Common::time_ns();
+        int64_t timestamp_ns           = prev_timestamp_ns + (int64_t)(delta_time * 1'000'000'000.0);
+        if (prev_timestamp_ns == 0 || timestamp_ns > now_ns || now_ns - timestamp_ns > max_drift_ns) timestamp_ns = now_ns;
+        prev_timestamp_ns = timestamp_ns;
+        return timestamp_ns;
+    }
 
     void midi_message_callback(double delta_time, std::vector<unsigned char>* message, void* user_data) {
         MidiMessage midi_message{};
-        midi_message.status = message->at(0);
+        midi_message.timestamp_ns = message_timestamp(delta_time);
+        midi_message.status       = message->at(0);
         if (message->size() > 1) midi_message.data1 = message->at(1);
         if (message->size() > 2) midi_message.data2 = message->at(2);
         if (message->size() > 3) midi_message.data3 = message->at(3);
 
-        mutex.lock();
-        message_queue.push_back(midi_message);
-        mutex.unlock();
+        // If the queue is full the message is dropped and counted, we never block the MIDI driver thread
+        message_queue.push(midi_message);
+        if constexpr (Log::min_level <= Log::Level::Debug) trace_queue.push(midi_message);
     }
 
     void init() {
@@ -34,52 +54,73 @@ namespace Midi {
         midi_in->setCallback(&midi_message_callback);
     }
 
-    void process() {
-        if (message_queue.empty()) return;
-
-        mutex.lock();
-
-        for (auto& message: message_queue) {
-            const int type    = message.type();
-            const int channel = message.channel();
-
-            for (auto& track: Session::tracks()) {
-                // If the track isn't listening to this midi channel, skip the track
-                if ((track.midi_input_channel_mask & (1 << channel)) == 0) continue;
-
-                if (type == 0) {
-                    const uint8_t key      = message.data1;
-                    const uint8_t velocity = message.data2;
-                    track.midi_note_off(channel, key, velocity);
-                } else if (type == 1) {
-                    const uint8_t key      = message.data1;
-                    const uint8_t velocity = message.data2;
-
-                    if (velocity > 0) track.midi_note_on(channel, key, velocity);
-                    else track.midi_note_off(channel, key, velocity);
-                } else if (type == 2) {
-                    const uint8_t key      = message.data1;
-                    const uint8_t pressure = message.data2;
-                    track.midi_poly_aftertouch(channel, key, pressure);
-                } else if (type == 3) {
-                    const uint8_t id    = message.data1;
-                    const uint8_t value = message.data2;
-                    track.midi_control_change(channel, id, value);
-                } else if (type == 4) {
-                    const uint8_t program = message.data1;
-                    track.midi_program_change(channel, program);
-                } else if (type == 5) {
-                    const uint8_t pressure = message.data1;
-                    track.midi_channel_aftertouch(channel, pressure);
-                } else if (type == 6) {
-                    const uint16_t value = message.data16();
-                    track.midi_pitch_wheel(channel, value);
-                }
+    void update() {
+        MidiMessage message;
+        while (trace_queue.pop(message)) {
+            LOG(Debug, "[Channel %2i] MIDI message: type %i, data %i %i", message.channel(), message.type(), message.data1,
+                message.data2);
+        }
+
+        const uint64_t n_overflows = message_queue.n_overflows.load(std::memory_order_relaxed);
+        if (n_overflows != n_overflows_reported) {
+            LOG(Warning, "MIDI input queue overflowed, %llu message(s) dropped",
+                (unsigned long long)(n_overflows - n_overflows_reported));
+            n_overflows_reported = n_overflows;
+        }
+    }
+
+    void dispatch(MidiMessage message, const uint64_t sample_position) {
+        const Session::TrackList* track_list = Session::audio_tracks();
+        if (track_list == nullptr) return;
+
+        const int type    = message.type();
+        const int channel = message.channel();
+        for (const auto& track_ptr: track_list->tracks) {
+            Track& track = *track_ptr;
+            // If the track isn't listening to this midi channel, skip the track
+            if ((track.midi_input_channel_mask & (1 << channel)) == 0) continue;
+
+            if (type == 0) {
+                const uint8_t key      = message.data1;
+                const uint8_t velocity = message.data2;
+                track.midi_note_off(channel, key, velocity, sample_position);
+            } else if (type == 1) {
+                const uint8_t key      = message.data1;
+                const uint8_t velocity = message.data2;
+
+                if (velocity > 0) track.midi_note_on(channel, key, velocity, sample_position);
+                else track.midi_note_off(channel, key, velocity, sample_position);
+            } else if (type == 2) {
+                const uint8_t key      = message.data1;
+                const uint8_t pressure = message.data2;
+                track.midi_poly_aftertouch(channel, key, pressure);
+            } else if (type == 3) {
+                const uint8_t id    = message.data1;
+                const uint8_t value = message.data2;
+                track.midi_control_change(channel, id, value);
+            } else if (type == 4) {
+                const uint8_t program = message.data1;
+                track.midi_program_change(channel, program);
+            } else if (type == 5) {
+                const uint8_t pressure = message.data1;
+                track.midi_channel_aftertouch(channel, pressure);
+            } else if (type == 6) {
+                const uint16_t value = message.data16();
+                track.midi_pitch_wheel(channel, value, sample_position);
             }
         }
+    }
 
-        mutex.unlock();
+    void process() {
+        if (Session::audio_tracks() == nullptr) return;
 
-        message_queue.clear();
+        MidiMessage message;
+        while (message_queue.pop(message)) {
+            dispatch(message, Mixer::sample_position_from_wall_time(message.timestamp_ns));
+        }
     }
+
+    bool queue_message(const MidiMessage& message) { return message_queue.push(message); }
+
+    uint64_t n_dropped_messages() { return message_queue.n_overflows.load(std::memory_order_relaxed); }
 } // namespace Midi
@@ -3,7 +3,12 @@
 
 namespace Midi {
     void init();
+    // Dispatch queued MIDI messages to the tracks. Runs on the audio thread at the start of every block, inside
+    // Rcu::begin_read() and Rcu::end_read().
     void process();
+    // Non-realtime housekeeping, like reporting dropped messages. Call this from the main loop.
+    void update();
+    uint64_t n_dropped_messages();
 
     constexpr int midi_channel_global = -1;
 
@@ -12,6 +17,7 @@ namespace Midi {
         uint8_t data1;
         uint8_t data2;
         uint8_t data3;
+        int64_t timestamp_ns; // When the message arrived, in Common::time_ns() time
 
         int channel() {
             if ((status & 0xF0) != 0xF0) return (status & 0x0F);
@@ -20,6 +26,14 @@ namespace Midi {
 
         int type() { return (status >> 4) & 0x07; }
 
-        uint16_t data16() { return (data2 << 8) + data1; }
+        // 14-bit value, both data bytes only carry 7 bits
+        uint16_t data16() { return (uint16_t)((data2 << 7) | data1); }
     };
+
+    // Queue a message as if it came from the MIDI input, it gets dispatched by the next process(). Only for when no MIDI
+    // device is open (headless renders, benchmarks), the queue only supports one producer.
+    bool queue_message(const MidiMessage& message);
+    // Send a message straight to the tracks listening on its channel, scheduled at an absolute `sample_position`. This is
+    // what process() does for every queued message. Audio thread, between Rcu::begin_read() and Rcu::end_read().
+    void dispatch(MidiMessage message, const uint64_t sample_position);
 } // namespace Midi
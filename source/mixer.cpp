@@ -1,37 +1,187 @@
+#include "analyzer.hpp"
 #include "log.hpp"
+#include "master_bus.hpp"
+#include "midi.hpp"
 #include "mixer.hpp"
 #include "processor.hpp"
+#include "rcu.hpp"
+#include "realtime.hpp"
+#include "scheduler.hpp"
+#include "common.hpp"
+#include "wav_writer.hpp"
+#include "xruns.hpp"
 #include "processors/wav_osc.hpp"
 
 #include <cmath>
 #include <cstdio>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <cstring>
+#include <atomic>
+#include <algorithm>
 #include <portaudio.h>
 
 namespace Mixer {
-    PaStream* stream                = NULL;
-    const double output_sample_rate = 44100;
-    double block_start_time_value   = 0.0;
-    double global_volume_value      = 0.8;
+    PaStream* stream                  = NULL;
+    double output_sample_rate         = 44100; // Only changes while the stream is stopped
+    bool portaudio_initialized        = false;
+    uint64_t block_start_sample_value = 0;
+    AudioConfig current_config;
 
-    std::vector<std::shared_ptr<Processor>> processors;
+    // Timing of the most recent block, published by the audio thread so other threads can map wall clock time onto the
+    // output stream. This is a seqlock: the sequence number is odd while the audio thread is writing.
+    struct {
+        std::atomic<uint32_t> sequence     = 0;
+        std::atomic<uint64_t> start_sample = 0;
+        std::atomic<int64_t> start_wall_ns = 0;
+        std::atomic<uint32_t> n_frames     = 0;
+    } block_timing;
+
+    // The graph is edited on the UI thread. Every edit compiles a new schedule, which the audio thread picks up at the start
+    // of the next block.
+    AudioGraph graph;
+    Rcu::Ptr<GraphSchedule> current_schedule;
+    // Master volume, limiter and clipper, applied to the output of the graph. Audio thread only, except while the stream is
+    // stopped.
+    MasterBus master_bus;
+    LevelMeter master_meter;
+    // Prepared for the default rate from the start, so rendering before the first set_audio_config() (benchmarks, tools)
+    // still goes through the whole master stage. set_audio_config() prepares it again for the actual rate.
+    const bool master_bus_prepared = (master_bus.prepare(output_sample_rate), true);
+
+    // Written by the audio thread at the end of every block
+    TimingStats callback_timing_stats;
+    struct {
+        std::atomic<double> current       = 0.0;
+        std::atomic<double> peak          = 0.0;
+        std::atomic<uint64_t> busy_ns     = 0;
+        std::atomic<uint64_t> budget_ns   = 0;
+        std::atomic<bool> reset_requested = false;
+    } load_stats;
+
+    struct LevelJob {
+        GraphSchedule* schedule;
+        size_t first_step;
+        size_t n_frames;
+    };
+
+    void publish_block_timing(const size_t n_frames) {
+        const uint32_t sequence = block_timing.sequence.load(std::memory_order_relaxed);
+        block_timing.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        block_timing.start_sample.store(block_start_sample_value, std::memory_order_relaxed);
+        block_timing.start_wall_ns.store(Common::time_ns(), std::memory_order_relaxed);
+        block_timing.n_frames.store((uint32_t)n_frames, std::memory_order_relaxed);
+        block_timing.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void publish_graph() {
+        current_schedule.publish(graph.compile(max_block_frames));
+        Rcu::reclaim();
+    }
+
+    void record_callback_timing(const int64_t time_start_ns, const size_t n_frames) {
+        const int64_t duration_ns = Common::time_ns() - time_start_ns;
+        const double budget_ns    = (double)n_frames / output_sample_rate * 1'000'000'000.0;
+        const double load         = (budget_ns > 0.0) ? ((double)duration_ns / budget_ns) : 0.0;
+        callback_timing_stats.record(duration_ns);
+
+        if (load_stats.reset_requested.exchange(false, std::memory_order_relaxed)) {
+            load_stats.peak.store(0.0, std::memory_order_relaxed);
+            load_stats.busy_ns.store(0, std::memory_order_relaxed);
+            load_stats.budget_ns.store(0, std::memory_order_relaxed);
+        }
+        load_stats.current.store(load, std::memory_order_relaxed);
+        if (load > load_stats.peak.load(std::memory_order_relaxed)) load_stats.peak.store(load, std::memory_order_relaxed);
+        load_stats.busy_ns.store(
+            load_stats.busy_ns.load(std::memory_order_relaxed) + (uint64_t)std::max(duration_ns, (int64_t)0),
+            std::memory_order_relaxed);
+        load_stats.budget_ns.store(
+            load_stats.budget_ns.load(std::memory_order_relaxed) + (uint64_t)budget_ns, std::memory_order_relaxed);
+    }
+
+    // Sum a node's inputs into its buffer, then run its processor on top of that
+    void run_step_job(size_t index, void* user_data) {
+        const auto& job        = *(const LevelJob*)user_data;
+        const auto& step       = job.schedule->steps[job.first_step + index];
+        float* output          = job.schedule->buffer(step.output_buffer);
+        const size_t n_samples = 2 * job.n_frames;
+
+        memset(output, 0, sizeof(float) * n_samples);
+        for (size_t i = 0; i < step.n_inputs; ++i) {
+            const auto& input   = job.schedule->inputs[step.first_input + i];
+            const float* source = job.schedule->buffer(input.buffer);
+            for (size_t j = 0; j < n_samples; ++j) {
+                output[j] += source[j] * input.gain;
+            }
+        }
+
+        if (step.processor != nullptr) step.processor->render(job.n_frames, output);
+    }
+
+    void render_block(const size_t n_frames, float* output) {
+        publish_block_timing(n_frames);
+
+        GraphSchedule* schedule = current_schedule.load();
+
+        for (size_t offset = 0; offset < n_frames; offset += max_block_frames) {
+            const size_t n_chunk_frames = std::min(n_frames - offset, max_block_frames);
+            float* chunk_output         = output + 2 * offset;
+
+            if (schedule == nullptr) {
+                memset(chunk_output, 0, sizeof(float) * 2 * n_chunk_frames);
+            } else {
+                // Levels run one after the other, the nodes within a level are spread over the worker threads
+                for (size_t level = 0; level < schedule->n_levels(); ++level) {
+                    LevelJob job         = {schedule, schedule->level_offsets[level], n_chunk_frames};
+                    const size_t n_steps = schedule->level_offsets[level + 1] - schedule->level_offsets[level];
+                    Scheduler::run(n_steps, &run_step_job, &job);
+                }
+                memcpy(chunk_output, schedule->buffer(schedule->master_buffer), sizeof(float) * 2 * n_chunk_frames);
+                for (Processor* processor: schedule->unreachable) {
+                    processor->skip(n_chunk_frames);
+                }
+            }
+            master_bus.process(chunk_output, n_chunk_frames);
+            master_meter.process(chunk_output, n_chunk_frames, output_sample_rate);
+            Analyzer::write(chunk_output, n_chunk_frames, output_sample_rate);
+
+            block_start_sample_value += n_chunk_frames;
+        }
+    }
 
     int pa_callback(
         const void*, void* output_buffer, unsigned long frames_per_buffer, const PaStreamCallbackTimeInfo* time_info,
         PaStreamCallbackFlags flags, void* user_data) {
         (void)user_data;
-        (void)flags;
-        (void)time_info;
-
-        memset(output_buffer, 0, sizeof(float) * 2 * frames_per_buffer);
+        const int64_t time_start_ns = Common::time_ns();
 
-        for (auto& processor: processors) {
-            processor->process_block(frames_per_buffer, (float*)output_buffer);
+        // The stream can be reopened on a different thread, so this is tracked per thread. Logging isn't real-time safe,
+        // but this only happens on the very first callback.
+        static thread_local bool thread_set_up = false;
+        if (!thread_set_up) {
+            Realtime::setup_thread("Audio callback", 0);
+            thread_set_up = true;
         }
 
-        block_start_time_value += (1.0 / output_sample_rate) * frames_per_buffer;
+        // Some host APIs leave the timestamps at zero, only trust them if they're filled in
+        const bool has_dac_time = time_info != NULL && time_info->outputBufferDacTime > 0.0;
+        Xruns::record_callback({
+            .time_ns          = time_start_ns,
+            .n_frames         = frames_per_buffer,
+            .output_underflow = (flags & paOutputUnderflow) != 0,
+            .output_overflow  = (flags & paOutputOverflow) != 0,
+            .past_deadline    = has_dac_time && time_info->outputBufferDacTime < time_info->currentTime,
+        });
+
+        // Deliver incoming MIDI before rendering, so the events land in this block instead of waiting for the UI thread
+        Rcu::begin_read();
+        Midi::process();
+        render_block(frames_per_buffer, (float*)output_buffer);
+        Rcu::end_read();
+
+        record_callback_timing(time_start_ns, frames_per_buffer);
 
         return paContinue;
     }
@@ -41,56 +191,357 @@ namespace Mixer {
         return;
     }
 
-    void init() {
-        Pa_Initialize();
+    void close_stream() {
+        if (stream == NULL) return;
+        Pa_StopStream(stream);
+        Pa_CloseStream(stream);
+        stream = NULL;
+    }
 
-        const int device_index = Pa_GetDefaultOutputDevice();
-        if (device_index == paNoDevice) {
+    PaDeviceIndex find_output_device(const std::string& name) {
+        if (!name.empty()) {
+            const PaDeviceIndex n_devices = Pa_GetDeviceCount();
+            for (PaDeviceIndex i = 0; i < n_devices; ++i) {
+                const PaDeviceInfo* device_info = Pa_GetDeviceInfo(i);
+                if (device_info != NULL && device_info->maxOutputChannels >= 2 && name == device_info->name) return i;
+            }
+            LOG(Warning, "Audio output device \"%s\" not found, using the default device", name.c_str());
+        }
+        return Pa_GetDefaultOutputDevice();
+    }
+
+    bool open_stream(const AudioConfig& config) {
+        const PaDeviceIndex device_index = find_output_device(config.device_name);
+        const PaDeviceInfo* device_info  = (device_index == paNoDevice) ? NULL : Pa_GetDeviceInfo(device_index);
+        if (device_info == NULL) {
             LOG(Error, "Failed to get audio output device\n");
-            return;
+            return false;
         }
 
-        const PaStreamParameters output_parameters = {
-            device_index, 2, paFloat32, Pa_GetDeviceInfo(device_index)->defaultLowOutputLatency, NULL,
-        };
+        const PaTime latency =
+            (config.latency_ms > 0.0) ? (config.latency_ms / 1000.0) : device_info->defaultLowOutputLatency;
+        const PaStreamParameters output_parameters = {device_index, 2, paFloat32, latency, NULL};
 
-        const PaDeviceInfo* device_info = Pa_GetDeviceInfo(device_index);
-        if (device_info != NULL) {
-            LOG(Info, "Audio output device: \"%s\"\n", device_info->name);
+        PaError error = Pa_IsFormatSupported(NULL, &output_parameters, config.sample_rate);
+        if (error != paNoError) {
+            LOG(Error, "Audio output device \"%s\" does not support %.0f Hz stereo output: %s", device_info->name,
+                config.sample_rate, Pa_GetErrorText(error));
+            return false;
         }
 
-        PaError error = Pa_OpenStream(
-            &stream, NULL, &output_parameters, output_sample_rate, paFramesPerBufferUnspecified, paClipOff, &pa_callback,
+        const unsigned long frames_per_buffer =
+            (config.block_size > 0) ? (unsigned long)config.block_size : paFramesPerBufferUnspecified;
+        error = Pa_OpenStream(
+            &stream, NULL, &output_parameters, config.sample_rate, frames_per_buffer, paClipOff, &pa_callback,
             NULL // todo: userdata?
         );
         if (error != paNoError || stream == NULL) {
-            LOG(Error, "Failed to open audio stream!\n");
-            return;
+            LOG(Error, "Failed to open audio stream: %s\n", Pa_GetErrorText(error));
+            stream = NULL;
+            return false;
         }
 
         // Set stream finished callback
         error = Pa_SetStreamFinishedCallback(stream, &pa_stream_finished);
         if (error != paNoError) {
             LOG(Error, "Error setting up audio stream!\n");
-            Pa_CloseStream(stream);
-            stream = NULL;
-            return;
+            close_stream();
+            return false;
         }
 
+        Xruns::stream_started();
         error = Pa_StartStream(stream);
         if (error != paNoError) {
             LOG(Error, "Error setting up audio stream!\n");
             Pa_CloseStream(stream);
             stream = NULL;
-            return;
+            return false;
+        }
+
+        const PaStreamInfo* stream_info = Pa_GetStreamInfo(stream);
+        LOG(Info, "Audio output device: \"%s\", %.0f Hz, block size %s, output latency %.1f ms\n", device_info->name,
+            config.sample_rate, (config.block_size > 0) ? std::to_string(config.block_size).c_str() : "unspecified",
+            (stream_info != NULL) ? stream_info->outputLatency * 1000.0 : 0.0);
+        return true;
+    }
+
+    // Only called while the audio thread is stopped, so processors can reallocate and recompute whatever they like
+    void prepare_processors() {
+        for (const auto& node: graph.nodes) {
+            if (node.processor != nullptr) node.processor->set_sample_rate(output_sample_rate);
+        }
+        master_bus.prepare(output_sample_rate);
+    }
+
+    void update() { Rcu::reclaim(); }
+
+    void init() {
+        Scheduler::init();
+        Pa_Initialize();
+        portaudio_initialized = true;
+
+        for (const auto& device: output_devices()) {
+            LOG(Info, "Found audio output device %i: \"%s\" (%s, %i channels, %.0f Hz, %.1f ms)", device.index,
+                device.name.c_str(), device.host_api.c_str(), device.max_output_channels, device.default_sample_rate,
+                device.default_latency_ms);
+        }
+
+        AudioConfig config;
+        config.load(AudioConfig::default_path);
+        if (!set_audio_config(config)) {
+            // Fall back to the default device at the default settings, those are the most likely to work
+            LOG(Warning, "Falling back to the default audio settings");
+            set_audio_config(AudioConfig{});
+        }
+    }
+
+    std::vector<AudioDevice> output_devices() {
+        std::vector<AudioDevice> devices;
+        if (!portaudio_initialized) return devices;
+
+        const PaDeviceIndex n_devices = Pa_GetDeviceCount();
+        for (PaDeviceIndex i = 0; i < n_devices; ++i) {
+            const PaDeviceInfo* device_info = Pa_GetDeviceInfo(i);
+            if (device_info == NULL || device_info->maxOutputChannels < 2) continue;
+
+            const PaHostApiInfo* host_api_info = Pa_GetHostApiInfo(device_info->hostApi);
+            devices.push_back({
+                .index               = i,
+                .name                = device_info->name,
+                .host_api            = (host_api_info != NULL) ? host_api_info->name : "",
+                .max_output_channels = device_info->maxOutputChannels,
+                .default_sample_rate = device_info->defaultSampleRate,
+                .default_latency_ms  = device_info->defaultLowOutputLatency * 1000.0,
+            });
         }
+        return devices;
     }
 
-    void register_processor(std::shared_ptr<Processor> processor) { processors.push_back(processor); }
+    AudioConfig audio_config() { return current_config; }
+
+    bool set_audio_config(const AudioConfig& config) {
+        if (config.sample_rate <= 0.0) {
+            LOG(Error, "Invalid sample rate %f", config.sample_rate);
+            return false;
+        }
+
+        const AudioConfig previous_config = current_config;
+        const bool had_stream             = stream != NULL;
+        close_stream();
+
+        current_config     = config;
+        output_sample_rate = config.sample_rate;
+        prepare_processors();
+        if (!portaudio_initialized) return true;
+        if (open_stream(config)) return true;
+
+        // Go back to the settings that worked
+        if (had_stream) {
+            current_config     = previous_config;
+            output_sample_rate = previous_config.sample_rate;
+            prepare_processors();
+            open_stream(previous_config);
+        }
+        return false;
+    }
+
+    // Render `frames_total` frames in blocks of `block_size`, handing every block to `write`
+    void render_offline_blocks(
+        const size_t frames_total, const size_t block_size, const OfflineBlockCallback& before_block,
+        const std::function<void(const float*, size_t)>& write) {
+        // Same floating point behavior as the audio callback, so offline renders match live playback
+        Realtime::flush_denormals();
+        Scheduler::init();
+
+        std::vector<float> block(2 * block_size);
+        const uint64_t start_sample = block_start_sample_value;
+        size_t frames_rendered      = 0;
+        while (frames_rendered < frames_total) {
+            const size_t n_frames       = std::min(block_size, frames_total - frames_rendered);
+            const int64_t time_start_ns = Common::time_ns();
+            Rcu::begin_read();
+            if (before_block) before_block(block_start_sample_value - start_sample, n_frames);
+            render_block(n_frames, block.data());
+            Rcu::end_read();
+            record_callback_timing(time_start_ns, n_frames);
+            write(block.data(), n_frames);
+            frames_rendered += n_frames;
+        }
+    }
+
+    bool render_offline(
+        const char* path, const double length_sec, const size_t block_size, const OfflineBlockCallback& before_block) {
+        if (stream != NULL) {
+            LOG(Error, "Can not render offline while the audio stream is running");
+            return false;
+        }
+
+        WavWriter writer;
+        if (!writer.open(path, (uint32_t)output_sample_rate, 2)) return false;
+
+        const size_t frames_total = (size_t)(length_sec * output_sample_rate);
+        LOG(Info, "Rendering %.2f seconds of audio to \"%s\" (block size %zu)", length_sec, path, block_size);
+        const auto time_begin = std::chrono::steady_clock::now();
+
+        render_offline_blocks(frames_total, block_size, before_block, [&](const float* block, size_t n_frames) {
+            writer.write(block, n_frames);
+        });
+
+        const auto time_end      = std::chrono::steady_clock::now();
+        const double elapsed_sec = std::chrono::duration<double>(time_end - time_begin).count();
+        const double audio_sec   = (double)frames_total / output_sample_rate;
+        LOG(Info, "Rendered %.2f seconds of audio in %.3f seconds (%.1fx realtime)", audio_sec, elapsed_sec,
+            (elapsed_sec > 0.0) ? (audio_sec / elapsed_sec) : 0.0);
+
+        dump_timing(stdout);
+        writer.close();
+        return true;
+    }
+
+    bool render_offline(
+        std::vector<float>& output, const size_t n_frames, const size_t block_size, const OfflineBlockCallback& before_block) {
+        if (stream != NULL) {
+            LOG(Error, "Can not render offline while the audio stream is running");
+            return false;
+        }
+
+        output.clear();
+        output.reserve(2 * n_frames);
+        render_offline_blocks(n_frames, block_size, before_block, [&](const float* block, size_t n_block_frames) {
+            output.insert(output.end(), block, block + 2 * n_block_frames);
+        });
+        return true;
+    }
+
+    NodeID register_processor(std::shared_ptr<Processor> processor) {
+        const NodeID node = graph.add_processor(std::move(processor));
+        graph.connect(node, AudioGraph::master);
+        publish_graph();
+        return node;
+    }
+
+    NodeID add_processor(std::shared_ptr<Processor> processor, const std::string& name) {
+        const NodeID node = graph.add_processor(std::move(processor), name);
+        publish_graph();
+        return node;
+    }
+
+    NodeID add_bus(const std::string& name) {
+        const NodeID node = graph.add_bus(name);
+        publish_graph();
+        return node;
+    }
+
+    void remove_node(NodeID node) {
+        graph.remove_node(node);
+        publish_graph();
+    }
+
+    bool connect(NodeID source, NodeID dest, float gain) {
+        if (!graph.connect(source, dest, gain)) return false;
+        publish_graph();
+        return true;
+    }
+
+    void disconnect(NodeID source, NodeID dest) {
+        graph.disconnect(source, dest);
+        publish_graph();
+    }
+
+    NodeID master_node() { return AudioGraph::master; }
 
     double sample_rate() { return output_sample_rate; }
 
-    double block_start_time() { return block_start_time_value; }
+    double block_start_time() { return (double)block_start_sample_value / output_sample_rate; }
+
+    uint64_t block_start_sample() { return block_start_sample_value; }
+
+    uint64_t sample_position_from_wall_time(const int64_t time_ns) {
+        uint32_t sequence_begin;
+        uint64_t start_sample;
+        int64_t start_wall_ns;
+        uint32_t n_frames;
+        do {
+            sequence_begin = block_timing.sequence.load(std::memory_order_acquire);
+            start_sample   = block_timing.start_sample.load(std::memory_order_relaxed);
+            start_wall_ns  = block_timing.start_wall_ns.load(std::memory_order_relaxed);
+            n_frames       = block_timing.n_frames.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence_begin & 1) || sequence_begin != block_timing.sequence.load(std::memory_order_relaxed));
+
+        // Events that happened while block N was playing get scheduled into block N + 1, at the same offset relative to the
+        // start of the block. That adds a constant latency of one block, but no jitter.
+        const double offset_sec = (double)(time_ns - start_wall_ns) / 1'000'000'000.0;
+        const int64_t position  = (int64_t)(start_sample + n_frames) + (int64_t)floor(offset_sec * output_sample_rate);
+        return (position > 0) ? (uint64_t)position : 0;
+    }
+
+    double processing_latency() { return graph.latency(AudioGraph::master) + master_bus.latency_samples(); }
+
+    DspLoad dsp_load() {
+        DspLoad load;
+        load.current             = load_stats.current.load(std::memory_order_relaxed);
+        load.peak                = load_stats.peak.load(std::memory_order_relaxed);
+        const uint64_t budget_ns = load_stats.budget_ns.load(std::memory_order_relaxed);
+        if (budget_ns > 0) load.average = (double)load_stats.busy_ns.load(std::memory_order_relaxed) / (double)budget_ns;
+        return load;
+    }
+
+    TimingStats::Snapshot callback_timing() { return callback_timing_stats.snapshot(); }
+
+    void reset_timing() {
+        load_stats.reset_requested.store(true, std::memory_order_relaxed);
+        callback_timing_stats.request_reset();
+        for (const auto& node: graph.nodes) {
+            if (node.processor != nullptr) node.processor->timing.request_reset();
+        }
+    }
+
+    void print_timing_line(FILE* file, const char* name, const TimingStats::Snapshot& timing) {
+        fprintf(
+            file, "  %-24s %10llu calls, min %9.1f us, avg %9.1f us, max %9.1f us\n", name,
+            (unsigned long long)timing.n_measurements, timing.min_us, timing.avg_us, timing.max_us);
+    }
+
+    void dump_timing(FILE* file) {
+        const DspLoad load = dsp_load();
+        fprintf(
+            file, "DSP load: current %.1f%%, average %.1f%%, peak %.1f%%\n", load.current * 100.0, load.average * 100.0,
+            load.peak * 100.0);
+
+        const Xruns::Counters xruns = Xruns::counters();
+        fprintf(
+            file, "Xruns: %llu underflows, %llu overflows, %llu late callbacks in %llu callbacks\n",
+            (unsigned long long)xruns.n_underflows, (unsigned long long)xruns.n_overflows,
+            (unsigned long long)xruns.n_late_callbacks, (unsigned long long)xruns.n_callbacks);
+
+        const double latency = processing_latency();
+        fprintf(file, "Processing latency: %.1f samples (%.2f ms)\n", latency, latency / output_sample_rate * 1000.0);
 
-    double global_volume() { return global_volume_value; }
+        const auto callback = callback_timing();
+        print_timing_line(file, "(callback)", callback);
+        for (size_t i = 0; i < graph.nodes.size(); ++i) {
+            const auto& node = graph.nodes[i];
+            if (node.processor == nullptr) continue;
+
+            char name[64];
+            if (node.name.empty()) snprintf(name, sizeof(name), "processor %zu", i);
+            else snprintf(name, sizeof(name), "%s", node.name.c_str());
+            print_timing_line(file, name, node.processor->timing.snapshot());
+        }
+
+        // Histogram of the callback durations, leaving out the empty bins
+        fprintf(file, "Callback duration histogram:\n");
+        for (size_t i = 0; i < TimingStats::n_histogram_bins; ++i) {
+            if (callback.histogram[i] == 0) continue;
+            const unsigned long long bin_end = 1ull << i;
+            fprintf(file, "  < %8llu us: %llu\n", bin_end, (unsigned long long)callback.histogram[i]);
+        }
+    }
+
+    LevelMeter::Snapshot levels(NodeID node) {
+        if (node == AudioGraph::master) return master_meter.snapshot();
+        if (node >= graph.nodes.size() || graph.nodes[node].processor == nullptr) return {};
+        return graph.nodes[node].processor->meter.snapshot();
+    }
 } // namespace Mixer
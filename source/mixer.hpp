@@ -1,11 +1,92 @@
 #pragma once
 #include "processor.hpp"
+#include "audio_graph.hpp"
+#include "audio_config.hpp"
+#include "level_meter.hpp"
+#include "timing_stats.hpp"
+#include <cstdio>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
 
 namespace Mixer {
+    using NodeID = AudioGraph::NodeID;
+
+    // Share of the time budget of a block that was spent rendering it, 1.0 means the deadline was just barely made
+    struct DspLoad {
+        double current = 0.0; // Most recent block
+        double average = 0.0; // Since the last reset
+        double peak    = 0.0; // Since the last reset
+    };
+
+    struct AudioDevice {
+        int index;
+        std::string name;
+        std::string host_api;
+        int max_output_channels;
+        double default_sample_rate;
+        double default_latency_ms; // The device's default low output latency
+    };
+
+    // Processors never get asked to render more than this many frames at once, longer blocks are split up
+    constexpr size_t max_block_frames = 4096;
+
+    // Open the output stream, using the settings from AudioConfig::default_path if that file exists
     void init();
-    void register_processor(std::shared_ptr<Processor> processor);
+    // Non-realtime housekeeping, like freeing graph schedules the audio thread is done with. Call this from the main loop.
+    void update();
+    // Render one block of interleaved stereo audio. This is what the PortAudio callback runs, so offline renders produce the
+    // same output as live playback at the same block size. Call it between Rcu::begin_read() and Rcu::end_read().
+    void render_block(const size_t n_frames, float* output);
+    // Called before every block of an offline render, inside the Rcu read section, with the block's first frame (counted
+    // from the start of the render) and its length. Events for the block can be dispatched from here.
+    using OfflineBlockCallback = std::function<void(uint64_t block_offset, size_t n_frames)>;
+    // Render `length_sec` seconds of audio to a WAV file as fast as possible, without opening an audio stream, calling
+    // `before_block` before every block
+    bool render_offline(
+        const char* path, const double length_sec, const size_t block_size = 512,
+        const OfflineBlockCallback& before_block = nullptr);
+    // Same, but into `output` as interleaved stereo
+    bool render_offline(
+        std::vector<float>& output, const size_t n_frames, const size_t block_size = 512,
+        const OfflineBlockCallback& before_block = nullptr);
+    // Add a processor to the graph and route it straight into the master
+    NodeID register_processor(std::shared_ptr<Processor> processor);
+
+    // Audio graph editing. These are meant to be called from the UI thread, every change takes effect at the next block.
+    NodeID add_processor(std::shared_ptr<Processor> processor, const std::string& name = "");
+    NodeID add_bus(const std::string& name);
+    void remove_node(NodeID node);
+    bool connect(NodeID source, NodeID dest, float gain = 1.0f);
+    void disconnect(NodeID source, NodeID dest);
+    NodeID master_node();
     double sample_rate();
     double block_start_time();
-    double global_volume();
+    uint64_t block_start_sample();
+    // Map a Common::time_ns() timestamp onto an absolute sample position in the output stream
+    uint64_t sample_position_from_wall_time(const int64_t time_ns);
+    // Delay the audio graph and the master limiter add on top of the output stream's latency, in samples
+    double processing_latency();
+
+    // Output device and stream settings. These are meant to be called from the UI thread.
+    std::vector<AudioDevice> output_devices();
+    AudioConfig audio_config();
+    // Stop the stream, prepare every processor for the new sample rate and reopen the stream with the new settings. If the
+    // new settings don't work, the old ones are restored and false is returned. Without a running stream (headless renders)
+    // this only changes the sample rate.
+    bool set_audio_config(const AudioConfig& config);
+
+    // Performance monitoring, these can be called from any thread
+    DspLoad dsp_load();
+    TimingStats::Snapshot callback_timing();
+    // Clear the load and timing stats of the callback and of every processor. This walks the graph, so call it from the UI
+    // thread.
+    void reset_timing();
+    // Print the load and timing stats, including a line per processor. Call this from the UI thread.
+    void dump_timing(FILE* file);
+    // Output level of a node. Processors are measured after they render, the master after the master bus, so that is what
+    // the output device gets. Buses read as silent. Call this from the UI thread.
+    LevelMeter::Snapshot levels(NodeID node);
 } // namespace Mixer
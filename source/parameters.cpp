@@ -0,0 +1,99 @@
+#include "parameters.hpp"
+#include "log.hpp"
+#include "ui/panel_manager.hpp"
+
+#include <atomic>
+#include <vector>
+
+namespace Params {
+    struct UiBinding {
+        Handle handle;
+        const double* ui_value;
+        double last_value;
+    };
+
+    // Constant initialized, so they're usable from other files' static initializers, e.g. the mixer's master bus
+    std::atomic<double> values[max_parameters];
+    std::atomic<Handle> n_parameters = 0;
+
+    // Only touched by the UI thread. Created on first use for the same reason, and never destroyed, so processors that get
+    // destroyed at exit can still give their parameters back.
+    struct Registry {
+        std::string names[max_parameters];
+        std::vector<Handle> free_handles; // Destroyed slots, reused before new ones
+        std::vector<UiBinding> ui_bindings;
+    };
+
+    Registry& registry() {
+        static Registry* instance = new Registry;
+        return *instance;
+    }
+
+    Handle create(const std::string& name, double default_value) {
+        Registry& registry = Params::registry();
+        if (!registry.free_handles.empty()) {
+            const Handle handle = registry.free_handles.back();
+            registry.free_handles.pop_back();
+            registry.names[handle] = name;
+            values[handle].store(default_value, std::memory_order_relaxed);
+            return handle;
+        }
+
+        const Handle handle = n_parameters.load(std::memory_order_relaxed);
+        if (handle >= max_parameters) {
+            LOG(Error, "Ran out of parameter slots while creating \"%s\"", name.c_str());
+            return invalid;
+        }
+
+        registry.names[handle] = name;
+        values[handle].store(default_value, std::memory_order_relaxed);
+        n_parameters.store(handle + 1, std::memory_order_release);
+        return handle;
+    }
+
+    void destroy(Handle handle) {
+        if (handle >= n_parameters.load(std::memory_order_relaxed)) return;
+        Registry& registry = Params::registry();
+
+        // The bindings point into the value pool of a panel that may not outlive the processor
+        std::erase_if(registry.ui_bindings, [handle](const UiBinding& binding) { return binding.handle == handle; });
+        registry.names[handle].clear();
+        values[handle].store(0.0, std::memory_order_relaxed);
+        registry.free_handles.push_back(handle);
+    }
+
+    const std::string& name(Handle handle) {
+        static const std::string invalid_name = "(invalid)";
+        if (handle >= n_parameters.load(std::memory_order_acquire)) return invalid_name;
+        return registry().names[handle];
+    }
+
+    double get(Handle handle) {
+        if (handle >= max_parameters) return 0.0;
+        return values[handle].load(std::memory_order_relaxed);
+    }
+
+    void set(Handle handle, double value) {
+        if (handle >= max_parameters) return;
+        values[handle].store(value, std::memory_order_relaxed);
+    }
+
+    void bind_ui(Handle handle, size_t panel_index, const std::string& variable) {
+        if (handle == invalid || panel_index == (size_t)-1) return;
+
+        // std::map never moves its nodes, so the address of the value stays valid for as long as the panel lives
+        auto& panel           = UI::get_panel(panel_index);
+        const double* address = &panel.scene.value_pool.get<double>(variable);
+        registry().ui_bindings.push_back({handle, address, *address});
+        set(handle, *address);
+    }
+
+    void sync_ui() {
+        for (auto& binding: registry().ui_bindings) {
+            const double value = *binding.ui_value;
+            if (value == binding.last_value) continue;
+            binding.last_value = value;
+            set(binding.handle, value);
+        }
+    }
+} // namespace Params
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Registry of processor parameters. Processors create their parameters up front and get back integer handles, reading a
+// value through a handle is a single atomic load, so it is safe and cheap to do on the audio thread. The UI publishes its
+// values through the same handles, which means processors don't need a UI panel to run.
+namespace Params {
+    using Handle                    = uint32_t;
+    constexpr Handle invalid        = UINT32_MAX;
+    constexpr size_t max_parameters = 4096;
+
+    // Register a new parameter. Not real-time safe, call this while setting up the processor.
+    Handle create(const std::string& name, double default_value);
+    // Give the parameter's slot back so create() can reuse it, and unbind it from the UI. Call this from the UI thread once
+    // nothing reads the handle anymore, e.g. from the destructor of the processor that created it.
+    void destroy(Handle handle);
+    const std::string& name(Handle handle);
+
+    // Lock-free, can be called from any thread
+    double get(Handle handle);
+    void set(Handle handle, double value);
+
+    // Bind a parameter to a variable in a UI panel's value pool. sync_ui() copies the UI value into the parameter whenever
+    // it changes.
+    void bind_ui(Handle handle, size_t panel_index, const std::string& variable);
+    // Publish the UI values of all bound parameters. Call this from the UI thread, once per frame.
+    void sync_ui();
+} // namespace Params
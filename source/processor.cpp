@@ -1,2 +1,52 @@
 #include "processor.hpp"
 #include "mixer.hpp"
+#include "common.hpp"
+
+Processor::Processor() : sample_rate(Mixer::sample_rate()) {}
+
+void Processor::set_sample_rate(double new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+    this->prepare(new_sample_rate);
+}
+
+void Processor::queue_event(const NoteEvent& event) { this->event_queue.push(event); }
+
+void Processor::render(const size_t n_samples, float* output) {
+    const int64_t time_start_ns = Common::time_ns();
+    const uint64_t block_start  = Mixer::block_start_sample();
+    size_t offset               = 0;
+
+    while (offset < n_samples) {
+        // Render up until the next event, or the end of the block if there is none in this block
+        NoteEvent* event  = this->event_queue.peek();
+        size_t event_time = n_samples;
+        if (event != nullptr && event->sample_position < block_start + n_samples) {
+            event_time = (event->sample_position > block_start) ? (size_t)(event->sample_position - block_start) : 0;
+            if (event_time < offset) event_time = offset;
+        }
+
+        if (event_time > offset) {
+            this->process_block(event_time - offset, output + 2 * offset);
+            offset = event_time;
+        }
+
+        if (event_time == n_samples) break;
+
+        if (event->type == NoteEventType::key_on) this->key_on(event->key, event->velocity);
+        else if (event->type == NoteEventType::key_off) this->key_off(event->key);
+        else if (event->type == NoteEventType::pitch_bend) this->pitch_bend(event->pitch_bend);
+        this->event_queue.drop_front();
+    }
+
+    this->meter.process(output, n_samples, Mixer::sample_rate());
+    this->timing.record(Common::time_ns() - time_start_ns);
+}
+
+void Processor::skip(const size_t n_samples) {
+    const uint64_t block_end = Mixer::block_start_sample() + n_samples;
+    while (const NoteEvent* event = this->event_queue.peek()) {
+        if (event->sample_position >= block_end) break;
+        if (event->type == NoteEventType::key_off) this->key_off(event->key);
+        this->event_queue.drop_front();
+    }
+}
@@ -1,11 +1,53 @@
 #pragma once
+#include "level_meter.hpp"
+#include "spsc_ring.hpp"
+#include "timing_stats.hpp"
 #include <cstdint>
 #include <cstddef>
 
+enum class NoteEventType : uint8_t {
+    key_on = 0,
+    key_off,
+    pitch_bend,
+};
+
+struct NoteEvent {
+    uint64_t sample_position; // Absolute position in the output stream, in samples
+    NoteEventType type;
+    uint8_t key;
+    uint8_t velocity;
+    float pitch_bend = 0.0f; // In semitones, only used by pitch_bend events
+};
+
 struct Processor {
+    Processor();
     virtual void process_block(const size_t n_samples, float* output) = 0;
     virtual void key_on(uint8_t key, uint8_t velocity) {}
     virtual void key_off(uint8_t key) {}
+    virtual void pitch_bend(float semitones) {}
+    // Called when the sample rate changes, while the audio thread is stopped. Recompute any state that depends on it here.
+    virtual void prepare(double sample_rate) {}
+    // How far the processor delays its output, in samples at the output sample rate
+    virtual double latency_samples() const { return 0.0; }
+
+    // Set `sample_rate` and prepare() the processor for it
+    void set_sample_rate(double new_sample_rate);
+
+    // Schedule a note event. Events have to be queued in chronological order, from a single thread at a time (the audio
+    // thread during playback). Events that are already in the past when the block gets rendered are applied at the start
+    // of the block.
+    void queue_event(const NoteEvent& event);
+
+    // Render a block starting at Mixer::block_start_sample(). The block is split at the queued note events, so key_on() and
+    // key_off() get applied on the exact sample they were scheduled for.
+    void render(const size_t n_samples, float* output);
+    // Stand-in for render() when the processor isn't routed anywhere, so its output would go unheard. Drops the events of
+    // the block, except for key offs, so notes held while it was disconnected don't hang once it's connected again.
+    void skip(const size_t n_samples);
 
+    double sample_rate    = 0.0; // Rate process_block() runs at, which is higher than Mixer::sample_rate() when oversampled
     size_t ui_panel_index = -1;
+    SpscRing<NoteEvent, 1024> event_queue;
+    TimingStats timing; // How long render() takes per block
+    LevelMeter meter;   // Level of the buffer render() leaves behind, so including anything mixed in before it
 };
@@ -0,0 +1,57 @@
+#include "osc_kernels.hpp"
+#include "osc_kernels_impl.hpp"
+#include "../log.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
+
+namespace OscKernels {
+    // Defined in osc_kernels_avx2.cpp, returns nullptr if that file was built without AVX2 support
+    const KernelSet* avx2();
+
+    const KernelSet scalar_kernels = make_kernel_set<ScalarOps>("scalar");
+#ifdef OSC_KERNELS_SSE2
+    const KernelSet sse2_kernels = make_kernel_set<SseOps>("SSE2");
+#endif
+
+    bool cpu_supports_avx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        // The OS also has to save the YMM registers on context switches
+        __cpuid(info, 1);
+        const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+        const bool has_avx     = (info[2] & (1 << 28)) != 0;
+        if (!has_osxsave || !has_avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    const KernelSet& pick_best() {
+        if (cpu_supports_avx2() && avx2() != nullptr) return *avx2();
+#ifdef OSC_KERNELS_SSE2
+        return sse2_kernels;
+#else
+        return scalar_kernels;
+#endif
+    }
+
+    const KernelSet& scalar() { return scalar_kernels; }
+
+    const KernelSet& best() {
+        static const KernelSet& kernels = pick_best();
+        static const bool logged        = (LOG(Info, "Using %s oscillator kernels", kernels.name), true);
+        (void)logged;
+        return kernels;
+    }
+} // namespace OscKernels
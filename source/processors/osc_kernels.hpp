@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+// Block oscillator kernels. Each kernel renders `n_samples` of a single voice into `output`, starting at `phase` (in cycles,
+// 0.0 to 1.0) and advancing by `phase_inc` cycles per sample. They return the phase after the last sample. `pulse_width`
+// points to one value per sample and is only used by the square wave.
+namespace OscKernels {
+    using RenderFunc =
+        double (*)(float* output, size_t n_samples, double phase, double phase_inc, const float* pulse_width);
+
+    struct KernelSet {
+        const char* name;
+        RenderFunc sine;
+        RenderFunc square;
+        RenderFunc triangle;
+        RenderFunc sawtooth;
+    };
+
+    // Portable reference implementation
+    const KernelSet& scalar();
+    // Fastest kernel set the CPU we're running on supports. Picked on the first call.
+    const KernelSet& best();
+} // namespace OscKernels
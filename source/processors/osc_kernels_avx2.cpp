@@ -0,0 +1,17 @@
+// This file is compiled with AVX2 enabled (see CMakeLists.txt). Nothing in here may run unless OscKernels::best() has
+// checked that the CPU supports it.
+#include "osc_kernels.hpp"
+#include "osc_kernels_impl.hpp"
+
+namespace OscKernels {
+#ifdef OSC_KERNELS_AVX2
+    // Function local, so the compiler's initializer code (which may well use AVX2 itself) only runs on the first call,
+    // after the CPU check. A namespace scope object would get initialized at startup on every CPU.
+    const KernelSet* avx2() {
+        static const KernelSet avx2_kernels = make_kernel_set<Avx2Ops>("AVX2");
+        return &avx2_kernels;
+    }
+#else
+    const KernelSet* avx2() { return nullptr; }
+#endif
+} // namespace OscKernels
@@ -0,0 +1,194 @@
+#pragma once
+// Oscillator kernels, written once against a small set of vector operations and instantiated for every instruction set.
+// Only include this from the osc_kernels*.cpp files. Everything lives in an anonymous namespace, because those files are
+// compiled with different instruction sets enabled, and the linker must not mix up their template instantiations.
+#include "osc_kernels.hpp"
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OSC_KERNELS_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+    #define OSC_KERNELS_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace {
+    struct ScalarOps {
+        using V                       = float;
+        using M                       = bool;
+        static constexpr size_t width = 1;
+
+        static V set1(float x) { return x; }
+        static V ramp(float start, float) { return start; }
+        static V add(V a, V b) { return a + b; }
+        static V sub(V a, V b) { return a - b; }
+        static V mul(V a, V b) { return a * b; }
+        static M lt(V a, V b) { return a < b; }
+        static M gt(V a, V b) { return a > b; }
+        static V select(M mask, V a, V b) { return mask ? a : b; }
+        static V frac(V a) { return a - (float)(int32_t)a; } // Only valid for positive values
+        static V load(const float* p) { return *p; }
+        static void store(float* p, V v) { *p = v; }
+    };
+
+#ifdef OSC_KERNELS_SSE2
+    struct SseOps {
+        using V                       = __m128;
+        using M                       = __m128;
+        static constexpr size_t width = 4;
+
+        static V set1(float x) { return _mm_set1_ps(x); }
+        static V ramp(float start, float step) {
+            return _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step)));
+        }
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static M lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+        static M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+        static V select(M mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        static V frac(V a) { return _mm_sub_ps(a, _mm_cvtepi32_ps(_mm_cvttps_epi32(a))); }
+        static V load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    };
+#endif
+
+#ifdef OSC_KERNELS_AVX2
+    struct Avx2Ops {
+        using V                       = __m256;
+        using M                       = __m256;
+        static constexpr size_t width = 8;
+
+        static V set1(float x) { return _mm256_set1_ps(x); }
+        static V ramp(float start, float step) {
+            const V lanes = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+            return _mm256_add_ps(_mm256_set1_ps(start), _mm256_mul_ps(lanes, _mm256_set1_ps(step)));
+        }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static M gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static V select(M mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+        static V frac(V a) { return _mm256_sub_ps(a, _mm256_floor_ps(a)); }
+        static V load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    };
+#endif
+
+    double wrap_phase(double phase) { return phase - floor(phase); }
+
+    // PolyBLEP residual, smooths out the discontinuity at t = 0
+    template <typename Ops> typename Ops::V poly_blep(typename Ops::V t, typename Ops::V dt, typename Ops::V inv_dt) {
+        using V      = typename Ops::V;
+        const V one  = Ops::set1(1.0f);
+        const V zero = Ops::set1(0.0f);
+
+        // Right after the discontinuity
+        const V u_start = Ops::mul(t, inv_dt);
+        const V r_start = Ops::sub(Ops::sub(Ops::add(u_start, u_start), Ops::mul(u_start, u_start)), one);
+
+        // Right before the discontinuity
+        const V u_end = Ops::mul(Ops::sub(t, one), inv_dt);
+        const V r_end = Ops::add(Ops::add(Ops::mul(u_end, u_end), Ops::add(u_end, u_end)), one);
+
+        return Ops::select(Ops::lt(t, dt), r_start, Ops::select(Ops::gt(t, Ops::sub(one, dt)), r_end, zero));
+    }
+
+    struct SineWave {
+        template <typename Ops>
+        static typename Ops::V sample(typename Ops::V t, typename Ops::V, typename Ops::V, typename Ops::V) {
+            using V = typename Ops::V;
+            // sin(2pi * t) = -sin(2pi * x) with x = t - 0.5. Fold x into [-0.25, 0.25] and evaluate a polynomial there.
+            const V quarter = Ops::set1(0.25f);
+            const V half    = Ops::set1(0.5f);
+            V x             = Ops::sub(t, half);
+            x               = Ops::select(Ops::gt(x, quarter), Ops::sub(half, x), x);
+            x               = Ops::select(Ops::lt(x, Ops::set1(-0.25f)), Ops::sub(Ops::set1(-0.5f), x), x);
+
+            // Taylor series up to y^9, the error is below 4e-6 for |y| <= pi/2
+            const V y  = Ops::mul(x, Ops::set1(6.28318530718f));
+            const V y2 = Ops::mul(y, y);
+            V poly     = Ops::set1(1.0f / 362880.0f);
+            poly       = Ops::add(Ops::mul(poly, y2), Ops::set1(-1.0f / 5040.0f));
+            poly       = Ops::add(Ops::mul(poly, y2), Ops::set1(1.0f / 120.0f));
+            poly       = Ops::add(Ops::mul(poly, y2), Ops::set1(-1.0f / 6.0f));
+            poly       = Ops::add(Ops::mul(poly, y2), Ops::set1(1.0f));
+            return Ops::sub(Ops::set1(0.0f), Ops::mul(poly, y));
+        }
+    };
+
+    struct SquareWave {
+        template <typename Ops>
+        static typename Ops::V
+        sample(typename Ops::V t, typename Ops::V dt, typename Ops::V inv_dt, typename Ops::V pulse_width) {
+            using V         = typename Ops::V;
+            const V one     = Ops::set1(1.0f);
+            V raw           = Ops::select(Ops::lt(t, pulse_width), one, Ops::set1(-1.0f));
+            raw             = Ops::add(raw, poly_blep<Ops>(t, dt, inv_dt));
+            const V t_pulse = Ops::frac(Ops::add(Ops::sub(t, pulse_width), one));
+            return Ops::sub(raw, poly_blep<Ops>(t_pulse, dt, inv_dt));
+        }
+    };
+
+    struct TriangleWave {
+        template <typename Ops>
+        static typename Ops::V sample(typename Ops::V t, typename Ops::V, typename Ops::V, typename Ops::V) {
+            using V         = typename Ops::V;
+            const V four_t  = Ops::mul(t, Ops::set1(4.0f));
+            const V rising  = Ops::sub(four_t, Ops::set1(1.0f));
+            const V falling = Ops::sub(Ops::set1(3.0f), four_t);
+            return Ops::select(Ops::lt(t, Ops::set1(0.5f)), rising, falling);
+        }
+    };
+
+    struct SawtoothWave {
+        template <typename Ops>
+        static typename Ops::V sample(typename Ops::V t, typename Ops::V dt, typename Ops::V inv_dt, typename Ops::V) {
+            using V     = typename Ops::V;
+            const V raw = Ops::sub(Ops::add(t, t), Ops::set1(1.0f));
+            return Ops::sub(raw, poly_blep<Ops>(t, dt, inv_dt));
+        }
+    };
+
+    template <typename Ops, typename Wave>
+    double render_wave(float* output, size_t n_samples, double phase, double phase_inc, const float* pulse_width) {
+        using V          = typename Ops::V;
+        const float dt   = (float)phase_inc;
+        const V dt_v     = Ops::set1(dt);
+        const V inv_dt_v = Ops::set1((dt > 0.0f) ? (1.0f / dt) : 0.0f);
+
+        size_t i = 0;
+        for (; i + Ops::width <= n_samples; i += Ops::width) {
+            // The phase of the first lane comes from the double precision phase, so rounding errors don't build up over
+            // the block
+            const double base_phase = wrap_phase(phase + (double)i * phase_inc);
+            const V t               = Ops::frac(Ops::ramp((float)base_phase, dt));
+            const V pw              = (pulse_width != nullptr) ? Ops::load(pulse_width + i) : Ops::set1(0.5f);
+            Ops::store(output + i, Wave::template sample<Ops>(t, dt_v, inv_dt_v, pw));
+        }
+
+        if constexpr (Ops::width > 1) {
+            if (i < n_samples) {
+                render_wave<ScalarOps, Wave>(
+                    output + i, n_samples - i, wrap_phase(phase + (double)i * phase_inc), phase_inc,
+                    (pulse_width != nullptr) ? (pulse_width + i) : nullptr);
+            }
+        }
+
+        return wrap_phase(phase + (double)n_samples * phase_inc);
+    }
+
+    template <typename Ops> OscKernels::KernelSet make_kernel_set(const char* name) {
+        return {
+            name,
+            &render_wave<Ops, SineWave>,
+            &render_wave<Ops, SquareWave>,
+            &render_wave<Ops, TriangleWave>,
+            &render_wave<Ops, SawtoothWave>,
+        };
+    }
+} // namespace
@@ -0,0 +1,168 @@
+#include "oversampler.hpp"
+#include "../common.hpp"
+#include "../log.hpp"
+#include "../mixer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define HALFBAND_SSE2
+    #include <emmintrin.h>
+#endif
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double bessel_i0(double x) {
+    double sum  = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+void HalfbandDecimator::init(size_t n_coef_pairs, double beta, size_t max_output_frames) {
+    // Kaiser windowed sinc with its cutoff at a quarter of the input rate. The taps at an even distance from the center are
+    // all zero, so only the odd ones get stored.
+    const double half_length = (double)(2 * n_coef_pairs);
+    double sum               = 0.0;
+    this->coefs.resize(n_coef_pairs);
+    for (size_t j = 0; j < n_coef_pairs; ++j) {
+        const double n      = (double)(2 * j + 1);
+        const double sinc   = ((j % 2 == 0) ? 1.0 : -1.0) / (M_PI * n);
+        const double window = bessel_i0(beta * sqrt(1.0 - (n / half_length) * (n / half_length))) / bessel_i0(beta);
+        this->coefs[j]      = (float)(sinc * window);
+        sum += sinc * window;
+    }
+
+    // Normalize for unity gain at DC, the center tap already contributes half of it
+    for (auto& coef: this->coefs) {
+        coef = (float)(coef * 0.25 / sum);
+    }
+
+    for (size_t channel = 0; channel < 2; ++channel) {
+        this->even[channel].resize(2 * n_coef_pairs - 1 + max_output_frames);
+        this->odd[channel].resize(n_coef_pairs + max_output_frames);
+    }
+    this->reset();
+}
+
+void HalfbandDecimator::reset() {
+    for (size_t channel = 0; channel < 2; ++channel) {
+        std::fill(this->even[channel].begin(), this->even[channel].end(), 0.0f);
+        std::fill(this->odd[channel].begin(), this->odd[channel].end(), 0.0f);
+    }
+}
+
+void HalfbandDecimator::process(const float* input, float* output, size_t n_output_frames) {
+    const size_t n_coefs      = this->coefs.size();
+    const size_t even_history = 2 * n_coefs - 1;
+    const size_t odd_history  = n_coefs;
+    const float* coefs        = this->coefs.data();
+    float* even[2]            = {this->even[0].data(), this->even[1].data()};
+    float* odd[2]             = {this->odd[0].data(), this->odd[1].data()};
+
+    // Split the input into its polyphase components. The input isn't read after this, so the output can overwrite it.
+    for (size_t i = 0; i < n_output_frames; ++i) {
+        even[0][even_history + i] = input[4 * i + 0];
+        even[1][even_history + i] = input[4 * i + 1];
+        odd[0][odd_history + i]   = input[4 * i + 2];
+        odd[1][odd_history + i]   = input[4 * i + 3];
+    }
+
+    // Output sample i is 0.5 * odd[i] plus coefs[j] * (even[i + n - 1 - j] + even[i + n + j]) for every j, with n the number
+    // of coefficients and the indices counting from the start of the history
+    size_t i = 0;
+#ifdef HALFBAND_SSE2
+    // Four frames at a time, both channels side by side
+    for (; i + 4 <= n_output_frames; i += 4) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        __m128 left       = _mm_mul_ps(_mm_loadu_ps(odd[0] + i), half);
+        __m128 right      = _mm_mul_ps(_mm_loadu_ps(odd[1] + i), half);
+        for (size_t j = 0; j < n_coefs; ++j) {
+            const __m128 coef       = _mm_set1_ps(coefs[j]);
+            const size_t before     = i + n_coefs - 1 - j;
+            const size_t after      = i + n_coefs + j;
+            const __m128 left_pair  = _mm_add_ps(_mm_loadu_ps(even[0] + before), _mm_loadu_ps(even[0] + after));
+            const __m128 right_pair = _mm_add_ps(_mm_loadu_ps(even[1] + before), _mm_loadu_ps(even[1] + after));
+            left                    = _mm_add_ps(left, _mm_mul_ps(left_pair, coef));
+            right                   = _mm_add_ps(right, _mm_mul_ps(right_pair, coef));
+        }
+        _mm_storeu_ps(output + 2 * i, _mm_unpacklo_ps(left, right));
+        _mm_storeu_ps(output + 2 * i + 4, _mm_unpackhi_ps(left, right));
+    }
+#endif
+    for (; i < n_output_frames; ++i) {
+        for (size_t channel = 0; channel < 2; ++channel) {
+            float sum = 0.5f * odd[channel][i];
+            for (size_t j = 0; j < n_coefs; ++j) {
+                sum += coefs[j] * (even[channel][i + n_coefs - 1 - j] + even[channel][i + n_coefs + j]);
+            }
+            output[2 * i + channel] = sum;
+        }
+    }
+
+    // Keep the end of this block around as the history for the next one
+    for (size_t channel = 0; channel < 2; ++channel) {
+        memmove(even[channel], even[channel] + n_output_frames, sizeof(float) * even_history);
+        memmove(odd[channel], odd[channel] + n_output_frames, sizeof(float) * odd_history);
+    }
+}
+
+Oversampler::Oversampler(std::shared_ptr<Processor> processor, size_t factor) {
+    if (factor != 2 && factor != 4) {
+        LOG(Warning, "Oversampling factor %zu is not supported, using 2x", factor);
+        factor = 2;
+    }
+    this->processor      = std::move(processor);
+    this->factor         = factor;
+    this->ui_panel_index = this->processor->ui_panel_index; // The wrapped processor's panel stands in for this one
+
+    // At 44.1 kHz, the last stage is flat up to 20 kHz, and everything from 24.1 kHz up (which would alias back below 20
+    // kHz) is attenuated by about 89 dB. The first stage only has to protect the band the last stage passes, so 31 taps
+    // give it about 91 dB.
+    this->first_stage.init(8, 9.0, Mixer::max_block_frames / 2);
+    this->last_stage.init(32, 9.0, Mixer::max_block_frames / factor);
+    this->oversampled.resize(2 * Mixer::max_block_frames);
+    this->processor->set_sample_rate(this->sample_rate * (double)factor);
+}
+
+void Oversampler::process_block(const size_t n_frames, float* output) {
+    // The wrapped processor can't render more than Mixer::max_block_frames at once either
+    const size_t max_chunk_frames = Mixer::max_block_frames / this->factor;
+    float* buffer                 = this->oversampled.data();
+
+    for (size_t offset = 0; offset < n_frames; offset += max_chunk_frames) {
+        const size_t n_chunk_frames = std::min(n_frames - offset, max_chunk_frames);
+        memset(buffer, 0, sizeof(float) * 2 * n_chunk_frames * this->factor);
+        this->processor->process_block(n_chunk_frames * this->factor, buffer);
+
+        if (this->factor == 4) this->first_stage.process(buffer, buffer, 2 * n_chunk_frames);
+        this->last_stage.process(buffer, buffer, n_chunk_frames);
+
+        float* chunk_output = output + 2 * offset;
+        for (size_t i = 0; i < 2 * n_chunk_frames; ++i) {
+            chunk_output[i] += buffer[i];
+        }
+    }
+}
+
+void Oversampler::key_on(uint8_t key, uint8_t velocity) { this->processor->key_on(key, velocity); }
+
+void Oversampler::key_off(uint8_t key) { this->processor->key_off(key); }
+
+void Oversampler::pitch_bend(float semitones) { this->processor->pitch_bend(semitones); }
+
+void Oversampler::prepare(double sample_rate) {
+    this->processor->set_sample_rate(sample_rate * (double)this->factor);
+    this->first_stage.reset();
+    this->last_stage.reset();
+}
+
+double Oversampler::latency_samples() const {
+    double latency = this->last_stage.latency() + this->processor->latency_samples() / (double)this->factor;
+    if (this->factor == 4) latency += this->first_stage.latency() / 2.0;
+    return latency;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "../processor.hpp"
+#include <memory>
+#include <vector>
+
+// Halves the sample rate of an interleaved stereo signal. It filters with a half-band FIR, where every other coefficient is
+// zero, split into its two polyphase branches: the even input samples go through a short symmetric FIR, and the odd input
+// samples only get delayed. Only the output samples that are kept get computed.
+struct HalfbandDecimator {
+    // `n_coef_pairs` sets the filter length (4 * n_coef_pairs - 1 taps), `beta` the shape of its Kaiser window
+    void init(size_t n_coef_pairs, double beta, size_t max_output_frames);
+    void reset();
+    // Read 2 * n_output_frames frames from `input` and write n_output_frames frames to `output`. `output` may point to
+    // `input`.
+    void process(const float* input, float* output, size_t n_output_frames);
+    // Group delay, in samples at the output rate
+    double latency() const { return (double)(4 * coefs.size() - 2) / 4.0; }
+
+    std::vector<float> coefs; // Non-zero coefficients on one side of the center tap, which is 0.5
+    // Per channel, the even and odd input samples of the current block, preceded by the history the filter needs
+    std::vector<float> even[2];
+    std::vector<float> odd[2];
+};
+
+// Runs a processor at 2x or 4x the output sample rate and decimates its output back down. Aliasing from waveforms that
+// aren't band-limited then mostly lands above the audible range and gets filtered out. Note events are forwarded to the
+// wrapped processor, and its output is mixed on top of the input.
+struct Oversampler : Processor {
+    Oversampler(std::shared_ptr<Processor> processor, size_t factor);
+    void process_block(const size_t n_frames, float* output) override;
+    virtual void key_on(uint8_t key, uint8_t velocity) override;
+    virtual void key_off(uint8_t key) override;
+    virtual void pitch_bend(float semitones) override;
+    virtual void prepare(double sample_rate) override;
+    virtual double latency_samples() const override;
+
+    std::shared_ptr<Processor> processor;
+    size_t factor = 1;
+    // At 4x, the first stage goes from 4x to 2x. Its transition band can be much wider, so it gets away with a short filter.
+    HalfbandDecimator first_stage;
+    HalfbandDecimator last_stage;
+    std::vector<float> oversampled;
+};
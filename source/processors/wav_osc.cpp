@@ -3,104 +3,173 @@
 #include "../common.hpp"
 #include "../ui/panel_manager.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <time.h>
 
-thread_local uint32_t noise_state = 0x796C694C;
+// Seed for the noise of one voice. Xorshift can't start from 0, and nearby counters should give unrelated streams, so the
+// seed and counter are run through an integer hash first.
+static uint32_t voice_noise_seed(uint32_t seed, uint64_t voice_counter) {
+    uint32_t x = seed ^ (uint32_t)voice_counter ^ (uint32_t)(voice_counter >> 32);
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    x ^= x >> 16;
+    return (x != 0) ? x : WavOsc::default_noise_seed;
+}
 
-double poly_blep(double t, double dt) {
-    if (t < dt) {
-        t /= dt;
-        return t + t - t * t - 1.0;
-    } else if (t > 1.0 - dt) {
-        t = (t - 1.0) / dt;
-        return t * t + t + t + 1.0;
-    }
-    return 0.0;
+void VoicePool::resize(size_t n_voices) {
+    this->vol_env.resize(n_voices);
+    this->actual_note.resize(n_voices);
+    this->velocity.resize(n_voices);
+    this->panning.resize(n_voices);
+    this->phase.resize(n_voices);
+    this->phase_inc.resize(n_voices);
+    this->noise_state.resize(n_voices);
+    this->key.resize(n_voices);
 }
 
-WavOsc::WavOsc() {
-    this->voice_pool.resize(2048);
+WavOsc::WavOsc(size_t max_polyphony) {
+    this->allocator.init(max_polyphony, this->sample_rate);
+    this->voice_pool.resize(this->allocator.pool_size());
+
+    // Parameters are stored in the same units as the UI shows them
+    auto& handles              = this->param_handles;
+    handles.wave_type          = Params::create("wave_type", (double)WaveType::sawtooth - 1.0);
+    handles.square_pulse_width = Params::create("square_pulse_width", this->square_pulse_width);
+    handles.unison_count       = Params::create("unison_count", this->unison_count);
+    handles.unison_depth       = Params::create("unison_depth", this->unison_depth);
+    handles.unison_wideness    = Params::create("unison_wideness", this->unison_wideness);
+    handles.unison_phase_shift = Params::create("unison_phase_shift", this->unison_phase_shift);
+    handles.adsr_delay         = Params::create("adsr_delay", this->params.delay);
+    handles.adsr_attack        = Params::create("adsr_attack", this->params.attack);
+    handles.adsr_hold          = Params::create("adsr_hold", this->params.hold);
+    handles.adsr_decay         = Params::create("adsr_decay", this->params.decay);
+    handles.adsr_sustain       = Params::create("adsr_sustain", this->params.sustain);
+    handles.adsr_release       = Params::create("adsr_release", 1.0 / this->params.release);
+    handles.steal_policy       = Params::create("steal_policy", (double)StealPolicy::release_first);
+
+    this->pulse_width_smoothed.init(this->sample_rate, 0.02, SmoothingType::linear);
+    this->sustain_smoothed.init(this->sample_rate, 0.02, SmoothingType::linear);
+    this->pulse_width_smoothed.snap(this->square_pulse_width);
+    this->sustain_smoothed.snap((float)this->params.sustain);
+    this->pulse_width_ramp.resize(Mixer::max_block_frames);
+    this->sustain_ramp.resize(Mixer::max_block_frames);
+    this->env_buffer.resize(Mixer::max_block_frames);
+    this->osc_buffer.resize(Mixer::max_block_frames);
+    this->kernels = &OscKernels::best();
+
     this->ui_panel_index = UI::load_panel("assets/layout/wav_osc.toml");
+    if (this->ui_panel_index == -1) return;
+
+    // The UI variables have the same names as the parameters
+    for (const Params::Handle handle: {
+             handles.wave_type, handles.square_pulse_width, handles.unison_count, handles.unison_depth,
+             handles.unison_wideness, handles.unison_phase_shift, handles.adsr_delay, handles.adsr_attack, handles.adsr_hold,
+             handles.adsr_decay, handles.adsr_sustain, handles.adsr_release}) {
+        Params::bind_ui(handle, this->ui_panel_index, Params::name(handle));
+    }
 }
 
-void WavOsc::process_block(const size_t n_frames, float* output) {
-    const double sample_length_sec = 1.0 / Mixer::sample_rate();
+WavOsc::~WavOsc() {
+    const auto& handles = this->param_handles;
+    for (const Params::Handle handle: {
+             handles.wave_type, handles.square_pulse_width, handles.unison_count, handles.unison_depth,
+             handles.unison_wideness, handles.unison_phase_shift, handles.adsr_delay, handles.adsr_attack, handles.adsr_hold,
+             handles.adsr_decay, handles.adsr_sustain, handles.adsr_release, handles.steal_policy}) {
+        Params::destroy(handle);
+    }
+}
 
-    if (this->ui_panel_index == -1) return;
+void WavOsc::process_block(const size_t n_frames, float* output) {
+    const double sample_length_sec = 1.0 / this->sample_rate;
+
+    const auto& handles      = this->param_handles;
+    this->unison_depth       = (float)Params::get(handles.unison_depth);
+    this->unison_wideness    = (float)Params::get(handles.unison_wideness);
+    this->unison_phase_shift = (float)Params::get(handles.unison_phase_shift);
+    this->unison_count       = (int)Params::get(handles.unison_count);
+
+    this->params.delay   = Params::get(handles.adsr_delay);
+    this->params.attack  = Params::get(handles.adsr_attack);
+    this->params.hold    = Params::get(handles.adsr_hold);
+    this->params.decay   = Params::get(handles.adsr_decay);
+    this->params.release = 1.0 / Params::get(handles.adsr_release);
+
+    this->pulse_width_smoothed.set_target((float)Params::get(handles.square_pulse_width));
+    this->sustain_smoothed.set_target((float)Params::get(handles.adsr_sustain));
+    this->pulse_width_smoothed.fill(this->pulse_width_ramp.data(), n_frames);
+    this->sustain_smoothed.fill(this->sustain_ramp.data(), n_frames);
+
+    // Nothing is playing, so there's nothing left to do
+    if (this->allocator.n_active() == 0) return;
+
+    OscKernels::RenderFunc render_wave = nullptr;
+    switch (this->wave_type) {
+        case WaveType::sine: render_wave = this->kernels->sine; break;
+        case WaveType::square: render_wave = this->kernels->square; break;
+        case WaveType::triangle: render_wave = this->kernels->triangle; break;
+        case WaveType::sawtooth: render_wave = this->kernels->sawtooth; break;
+        default: break;
+    }
 
-    auto& panel              = UI::get_panel(this->ui_panel_index);
-    this->square_pulse_width = (float)panel.scene.value_pool.get<double>("square_pulse_width");
-    this->unison_depth       = (float)panel.scene.value_pool.get<double>("unison_depth");
-    this->unison_wideness    = (float)panel.scene.value_pool.get<double>("unison_wideness");
-    this->unison_phase_shift = (float)panel.scene.value_pool.get<double>("unison_phase_shift");
-    this->unison_count       = (float)panel.scene.value_pool.get<double>("unison_count");
-
-    this->params.delay   = panel.scene.value_pool.get<double>("adsr_delay");
-    this->params.attack  = panel.scene.value_pool.get<double>("adsr_attack");
-    this->params.hold    = panel.scene.value_pool.get<double>("adsr_hold");
-    this->params.decay   = panel.scene.value_pool.get<double>("adsr_decay");
-    this->params.sustain = panel.scene.value_pool.get<double>("adsr_sustain");
-    this->params.release = 1.0 / panel.scene.value_pool.get<double>("adsr_release");
-
-    for (size_t i = 0; i < n_frames; ++i) {
-        for (auto& voice: this->voice_pool) {
-            if (voice.vol_env.stage == VolEnvStage::idle) continue;
-
-            voice.vol_env.tick(sample_length_sec, this->params);
-            const double key_relative_to_a4 = ((double)voice.actual_note) - 69.0;          // nice
-            const double frequency          = 440.0 * pow(2.0, key_relative_to_a4 / 12.0); // todo: non-440 hz tuning, pitch
-                                                                                           // wheel, mod vibrato, microtonality
-            double sample = 0.0;
-
-            if (this->wave_type == WaveType::sine) {
-                // todo: use a LUT
-                sample = sin(voice.phase * frequency * 2.0 * 3.14159265);
-            } else if (this->wave_type == WaveType::square) {
-                const double wave_time = (voice.phase * frequency);
-                const double phase     = wave_time - trunc(wave_time);
-                double raw_sample      = (phase < this->square_pulse_width) ? (+1.0) : (-1.0);
-                raw_sample += poly_blep(phase, frequency * sample_length_sec);
-                double t = phase - this->square_pulse_width;
-                if (t < 0.0) t += 1.0;
-                raw_sample -= poly_blep(t, frequency * sample_length_sec);
-                sample += raw_sample;
-            } else if (this->wave_type == WaveType::triangle) {
-                const double wave_time = (voice.phase * frequency);
-                const double t_wrap    = wave_time - trunc(wave_time);
-                if (t_wrap < 0.5) sample = (t_wrap * 4.0) - 1.0;
-                else sample = 1.0 - (t_wrap - 0.5) * 4.0;
-            } else if (this->wave_type == WaveType::sawtooth) {
-                const double wave_time = (voice.phase * frequency);
-                const double phase     = wave_time - trunc(wave_time);
-                double raw_sample      = (phase * 2.0) - 1.0;
-                raw_sample -= poly_blep(phase, frequency * sample_length_sec);
-                sample += raw_sample;
-            } else if (this->wave_type == WaveType::noise) {
-                uint32_t x = noise_state;
+    auto& voices = this->voice_pool;
+    float* env   = this->env_buffer.data();
+    float* osc   = this->osc_buffer.data();
+
+    // Render one voice at a time, so the oscillator and mixing loops run over whole blocks
+    for (size_t active_index = 0; active_index < this->allocator.active_voices.size();) {
+        const uint32_t voice_index = this->allocator.active_voices[active_index];
+
+        auto& vol_env = voices.vol_env[voice_index];
+        vol_env.render(env, n_frames, sample_length_sec, this->params, this->sustain_ramp.data());
+        const bool faded_out = this->allocator.apply_fade(voice_index, env, n_frames);
+
+        double& phase = voices.phase[voice_index];
+        if (render_wave != nullptr) {
+            phase = render_wave(osc, n_frames, phase, voices.phase_inc[voice_index], this->pulse_width_ramp.data());
+        } else if (this->wave_type == WaveType::noise) {
+            uint32_t& noise_state = voices.noise_state[voice_index];
+            uint32_t x            = noise_state;
+            for (size_t i = 0; i < n_frames; ++i) {
                 x ^= x << 13;
                 x ^= x >> 17;
                 x ^= x << 5;
-                noise_state = x;
-                sample      = (((double)x / (double)UINT32_MAX) * 2.0) - 1.0;
+                osc[i] = (float)((((double)x / (double)UINT32_MAX) * 2.0) - 1.0);
             }
-            const double volume_multiplier = (double)voice.velocity;
-            const double adsr_volume       = voice.vol_env.adsr_volume;
-            double final_volume            = volume_multiplier * adsr_volume * Mixer::global_volume();
-            final_volume                   = final_volume * final_volume;
-            output[2 * i + 0] += (float)(sample * final_volume) *
-                                 ((float)Common::lut_panning[0 + (size_t)((voice.panning + 1.0f) * 127.0)] / 4095.0f);
-            output[2 * i + 1] += (float)(sample * final_volume) *
-                                 ((float)Common::lut_panning[254 - (size_t)((voice.panning + 1.0f) * 127.0)] / 4095.0f);
-            voice.phase += sample_length_sec;
+            noise_state = x;
+        } else {
+            memset(osc, 0, n_frames * sizeof(float));
+        }
+
+        const float velocity   = voices.velocity[voice_index];
+        const size_t pan_index = (size_t)((voices.panning[voice_index] + 1.0f) * 127.0);
+        const float pan_left   = (float)Common::lut_panning[0 + pan_index] / 4095.0f;
+        const float pan_right  = (float)Common::lut_panning[254 - pan_index] / 4095.0f;
+        for (size_t i = 0; i < n_frames; ++i) {
+            float final_volume = velocity * env[i];
+            final_volume       = final_volume * final_volume;
+            const float sample = osc[i] * final_volume;
+            output[2 * i + 0] += sample * pan_left;
+            output[2 * i + 1] += sample * pan_right;
+        }
+
+        // Once the envelope has finished or a stolen voice has faded out, hand the voice back. The last active voice takes its
+        // place, so don't advance the index.
+        if (vol_env.stage == VolEnvStage::idle || faded_out) {
+            this->allocator.release(active_index);
+        } else {
+            ++active_index;
         }
     }
 }
 
 void WavOsc::key_on(uint8_t key, uint8_t velocity) {
-    auto& panel     = UI::get_panel(this->ui_panel_index);
-    this->wave_type = (WaveType)round(panel.scene.value_pool.get<double>("wave_type") + 1.0);
-    LOG(Debug, "wave_type = %i", (int)this->wave_type);
+    this->wave_type          = (WaveType)round(Params::get(this->param_handles.wave_type) + 1.0);
+    const StealPolicy policy = (StealPolicy)std::clamp(
+        (int)round(Params::get(this->param_handles.steal_policy)), 0, (int)StealPolicy::n_policies - 1);
 
     float fkey              = (float)key - (this->unison_depth / 2.0f);
     float fphase            = -this->unison_phase_shift / 2.0f;
@@ -115,21 +184,23 @@ void WavOsc::key_on(uint8_t key, uint8_t velocity) {
         fpan   = 0.0f;
     }
 
+    auto& voices = this->voice_pool;
+    this->allocator.begin_note();
     for (int i = 0; i < this->unison_count; ++i) {
-        for (auto& voice: this->voice_pool) {
-            if (voice.vol_env.stage != VolEnvStage::idle) continue;
-
-            float wrapped_phase      = (fphase < 0.0f) ? (fphase + 1.0f) : (fphase);
-            wrapped_phase            = (wrapped_phase >= 1.0f) ? (wrapped_phase - 1.0f) : (wrapped_phase);
-            voice.phase              = wrapped_phase;
-            voice.actual_note        = fkey;
-            voice.panning            = fpan;
-            voice.key                = key;
-            voice.velocity           = ((float)velocity / 127.0f) / sqrtf((float)this->unison_count);
-            voice.vol_env.stage      = VolEnvStage::delay;
-            voice.vol_env.stage_time = 0.0;
-            break;
-        }
+        const uint32_t voice_index = this->allocator.allocate(key, policy, voices.vol_env.data(), voices.key.data());
+        if (voice_index == VoiceAllocator::none) break;
+
+        float wrapped_phase                    = (fphase < 0.0f) ? (fphase + 1.0f) : (fphase);
+        wrapped_phase                          = (wrapped_phase >= 1.0f) ? (wrapped_phase - 1.0f) : (wrapped_phase);
+        voices.phase[voice_index]              = wrapped_phase;
+        voices.actual_note[voice_index]        = fkey;
+        voices.panning[voice_index]            = fpan;
+        voices.key[voice_index]                = key;
+        voices.noise_state[voice_index]        = voice_noise_seed(this->noise_seed, this->allocator.start_order[voice_index]);
+        voices.velocity[voice_index]           = ((float)velocity / 127.0f) / sqrtf((float)this->unison_count);
+        voices.vol_env[voice_index].stage      = VolEnvStage::delay;
+        voices.vol_env[voice_index].stage_time = 0.0;
+        this->update_phase_inc(voice_index);
 
         fkey += key_delta;
         fphase += phase_delta;
@@ -138,9 +209,31 @@ void WavOsc::key_on(uint8_t key, uint8_t velocity) {
 }
 
 void WavOsc::key_off(uint8_t key) {
-    for (auto& voice: this->voice_pool) {
-        if (voice.key == key) {
-            voice.vol_env.stage = VolEnvStage::release;
+    for (const uint32_t voice_index: this->allocator.active_voices) {
+        if (this->voice_pool.key[voice_index] == key) {
+            this->voice_pool.vol_env[voice_index].stage = VolEnvStage::release;
         }
     }
 }
+
+void WavOsc::pitch_bend(float semitones) {
+    this->pitch_bend_amount = semitones;
+    for (const uint32_t voice_index: this->allocator.active_voices) {
+        this->update_phase_inc(voice_index);
+    }
+}
+
+void WavOsc::prepare(double sample_rate) {
+    this->allocator.set_sample_rate(sample_rate);
+    this->pulse_width_smoothed.init(sample_rate, 0.02, SmoothingType::linear);
+    this->sustain_smoothed.init(sample_rate, 0.02, SmoothingType::linear);
+    for (const uint32_t voice_index: this->allocator.active_voices) {
+        this->update_phase_inc(voice_index);
+    }
+}
+
+void WavOsc::update_phase_inc(uint32_t voice_index) {
+    auto& voices                  = this->voice_pool;
+    const double note             = (double)voices.actual_note[voice_index] + (double)this->pitch_bend_amount;
+    voices.phase_inc[voice_index] = Common::note_frequency(note) / this->sample_rate;
+}
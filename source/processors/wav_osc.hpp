@@ -2,6 +2,10 @@
 
 #include "../processor.hpp"
 #include "../adsr.hpp"
+#include "../parameters.hpp"
+#include "../smoothed_value.hpp"
+#include "../voice_allocator.hpp"
+#include "osc_kernels.hpp"
 #include <vector>
 
 enum class WaveType {
@@ -13,27 +17,73 @@ enum class WaveType {
     noise,
 };
 
-struct Voice {
-    VolEnv vol_env;
-    float actual_note;
-    float velocity;
-    float panning;
-    double phase;
-    uint8_t key;
+// Voice state, with one array per field, so rendering a voice only pulls in the fields it needs
+struct VoicePool {
+    void resize(size_t n_voices);
+    size_t size() const { return key.size(); }
+
+    std::vector<VolEnv> vol_env;
+    std::vector<float> actual_note;
+    std::vector<float> velocity;
+    std::vector<float> panning;
+    std::vector<double> phase;         // In cycles, 0.0 to 1.0
+    std::vector<double> phase_inc;     // In cycles per sample, only recalculated when the pitch changes
+    std::vector<uint32_t> noise_state; // Xorshift state, seeded per voice so the noise doesn't depend on render order
+    std::vector<uint8_t> key;
 };
 
 struct WavOsc : Processor {
-    WavOsc();
+    static constexpr uint32_t default_noise_seed = 0x796C694C;
+
+    explicit WavOsc(size_t max_polyphony = 256);
+    ~WavOsc();
     void process_block(const size_t n_frames, float* output) override;
     virtual void key_on(uint8_t key, uint8_t velocity) override;
     virtual void key_off(uint8_t key) override;
+    virtual void pitch_bend(float semitones) override;
+    virtual void prepare(double sample_rate) override;
+    void update_phase_inc(uint32_t voice_index);
+    size_t n_active_voices() const { return allocator.n_active(); }
 
-    std::vector<Voice> voice_pool;
+    VoicePool voice_pool;
+    VoiceAllocator allocator;
     VolEnvParams params;
+
+    struct {
+        Params::Handle wave_type;
+        Params::Handle square_pulse_width;
+        Params::Handle unison_count;
+        Params::Handle unison_depth;
+        Params::Handle unison_wideness;
+        Params::Handle unison_phase_shift;
+        Params::Handle adsr_delay;
+        Params::Handle adsr_attack;
+        Params::Handle adsr_hold;
+        Params::Handle adsr_decay;
+        Params::Handle adsr_sustain;
+        Params::Handle adsr_release;
+        Params::Handle steal_policy;
+    } param_handles;
+
+    // Parameters that are read every sample glide to their new value, and get rendered into a ramp once per block
+    SmoothedValue pulse_width_smoothed;
+    SmoothedValue sustain_smoothed;
+    std::vector<float> pulse_width_ramp;
+    std::vector<float> sustain_ramp;
+
+    // Scratch buffers for rendering one voice at a time
+    std::vector<float> env_buffer;
+    std::vector<float> osc_buffer;
+    const OscKernels::KernelSet* kernels = nullptr;
+
     WaveType wave_type       = WaveType::sawtooth;
     float square_pulse_width = 0.375f;
     float unison_depth       = 0.3f;
     float unison_wideness    = 1.0f;
     float unison_phase_shift = 0.3f;
     int unison_count         = 9;
+    float pitch_bend_amount  = 0.0f; // In semitones
+    // Every noise voice gets its own stream, derived from this seed and the voice's start order. The same notes always
+    // produce the same noise, no matter which thread renders them or what else is playing.
+    uint32_t noise_seed = default_noise_seed;
 };
@@ -0,0 +1,109 @@
+#include "wavetable.hpp"
+#include "../fft.hpp"
+#include "../log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <mutex>
+
+std::shared_ptr<const Wavetable> Wavetable::create(const float* cycle, size_t n_samples) {
+    auto table = std::make_shared<Wavetable>();
+    if (cycle == nullptr || n_samples == 0) {
+        LOG(Error, "Can't create a wavetable from an empty cycle");
+        for (auto& level: table->levels) level.assign(table_size + 1, 0.0f);
+        return table;
+    }
+
+    // Resample the cycle to the table size
+    std::vector<std::complex<float>> spectrum(table_size);
+    for (size_t i = 0; i < table_size; ++i) {
+        const double position = (double)i * (double)n_samples / (double)table_size;
+        const size_t index    = (size_t)position;
+        const float t         = (float)(position - (double)index);
+        spectrum[i]           = std::lerp(cycle[index], cycle[(index + 1) % n_samples], t);
+    }
+    FFT::forward(spectrum.data(), table_size);
+
+    // Each level is the inverse FFT of the spectrum with the top harmonics cut off. DC gets removed from all of them.
+    std::vector<std::complex<float>> band(table_size);
+    float peak = 0.0f;
+    for (size_t level = 0; level < n_mip_levels; ++level) {
+        const size_t n_harmonics = max_harmonics >> level;
+        std::fill(band.begin(), band.end(), 0.0f);
+        for (size_t h = 1; h <= n_harmonics; ++h) {
+            band[h]              = spectrum[h];
+            band[table_size - h] = spectrum[table_size - h];
+        }
+        FFT::inverse(band.data(), table_size);
+
+        auto& samples = table->levels[level];
+        samples.resize(table_size + 1);
+        for (size_t i = 0; i < table_size; ++i) samples[i] = band[i].real();
+        samples[table_size] = samples[0];
+        if (level == 0) {
+            for (const float sample: samples) peak = std::max(peak, fabsf(sample));
+        }
+    }
+
+    // Normalize every level by the same amount, so switching levels doesn't change the volume
+    if (peak > 0.0f) {
+        for (auto& level: table->levels) {
+            for (float& sample: level) sample /= peak;
+        }
+    }
+    return table;
+}
+
+std::shared_ptr<const Wavetable> Wavetable::basic(WavetableShape shape) {
+    static std::mutex mutex;
+    static std::shared_ptr<const Wavetable> tables[(size_t)WavetableShape::n_shapes];
+
+    const size_t index = (size_t)shape;
+    if (index >= (size_t)WavetableShape::n_shapes) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tables[index] != nullptr) return tables[index];
+
+    std::vector<float> cycle(table_size);
+    for (size_t i = 0; i < table_size; ++i) {
+        const double t = (double)i / (double)table_size;
+        switch (shape) {
+            case WavetableShape::sine: cycle[i] = (float)sin(t * 2.0 * M_PI); break;
+            case WavetableShape::square: cycle[i] = (t < 0.5) ? 1.0f : -1.0f; break;
+            case WavetableShape::triangle: cycle[i] = (float)((t < 0.5) ? (t * 4.0 - 1.0) : (3.0 - t * 4.0)); break;
+            case WavetableShape::sawtooth: cycle[i] = (float)(t * 2.0 - 1.0); break;
+            default: break;
+        }
+    }
+    tables[index] = create(cycle.data(), cycle.size());
+    return tables[index];
+}
+
+size_t Wavetable::mip_level(double phase_inc) {
+    // Level n has (max_harmonics >> n) harmonics, which stay below Nyquist as long as phase_inc * harmonics <= 0.5
+    const double ratio = phase_inc * (double)(max_harmonics * 2);
+    if (ratio <= 1.0) return 0;
+    return std::min((size_t)ceil(log2(ratio)), n_mip_levels - 1);
+}
+
+double Wavetable::render(float* output, size_t n_samples, double phase, double phase_inc) const {
+    const float* table = this->levels[mip_level(phase_inc)].data();
+
+    // 32-bit fixed point phase, it wraps around on its own. The top 11 bits are the table index, the rest is the fraction
+    // for interpolating between two samples.
+    constexpr uint32_t fraction_bits = 32 - 11;
+    constexpr float fraction_scale   = 1.0f / (float)(1u << fraction_bits);
+    static_assert((1u << (32 - fraction_bits)) == table_size);
+
+    uint32_t position        = (uint32_t)(int64_t)(phase * 4294967296.0);
+    const uint32_t increment = (uint32_t)(int64_t)(phase_inc * 4294967296.0);
+    for (size_t i = 0; i < n_samples; ++i) {
+        const uint32_t index = position >> fraction_bits;
+        const float t        = (float)(position & ((1u << fraction_bits) - 1)) * fraction_scale;
+        output[i]            = table[index] + (table[index + 1] - table[index]) * t;
+        position += increment;
+    }
+
+    const double end_phase = phase + (double)n_samples * phase_inc;
+    return end_phase - floor(end_phase);
+}
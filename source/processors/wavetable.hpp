@@ -0,0 +1,38 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class WavetableShape {
+    sine = 0,
+    square,
+    triangle,
+    sawtooth,
+    n_shapes,
+};
+
+// Single-cycle waveform, stored as a stack of band-limited copies (mip levels). Level 0 keeps the first 512 harmonics, and
+// every level after that halves the number of harmonics, so each level is safe to play one octave higher than the one
+// before it. Tables are immutable once built, so one table can be shared by all voices of all tracks.
+struct Wavetable {
+    static constexpr size_t table_size    = 2048;
+    static constexpr size_t n_mip_levels  = 10;
+    static constexpr size_t max_harmonics = 512;
+
+    // Build a table from one cycle of a waveform. The cycle can be any length, it gets resampled to `table_size`.
+    // Not real-time safe.
+    static std::shared_ptr<const Wavetable> create(const float* cycle, size_t n_samples);
+    // Built-in shapes. These are generated on first use, and the same table is returned every time after that.
+    static std::shared_ptr<const Wavetable> basic(WavetableShape shape);
+
+    // Pick the mip level with the most harmonics that don't alias at this phase increment (in cycles per sample)
+    static size_t mip_level(double phase_inc);
+
+    // Render `n_samples` starting at `phase` (in cycles, 0.0 to 1.0), returns the phase after the last sample
+    double render(float* output, size_t n_samples, double phase, double phase_inc) const;
+
+    // Every level has one extra sample at the end, a copy of the first one, so lookups never need to wrap
+    std::array<std::vector<float>, n_mip_levels> levels;
+};
@@ -0,0 +1,135 @@
+#include "wavetable_osc.hpp"
+#include "../mixer.hpp"
+#include "../common.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+WavetableOsc::WavetableOsc(size_t max_polyphony) {
+    this->allocator.init(max_polyphony, this->sample_rate);
+    const size_t n_voices = this->allocator.pool_size();
+    auto& voices          = this->voices;
+    voices.vol_env.resize(n_voices);
+    voices.phase.resize(n_voices);
+    voices.phase_inc.resize(n_voices);
+    voices.velocity.resize(n_voices);
+    voices.key.resize(n_voices);
+
+    for (size_t i = 0; i < (size_t)WavetableShape::n_shapes; ++i) {
+        this->tables[i] = Wavetable::basic((WavetableShape)i);
+    }
+
+    auto& handles        = this->param_handles;
+    handles.shape        = Params::create("wavetable_shape", (double)WavetableShape::sawtooth);
+    handles.adsr_delay   = Params::create("adsr_delay", this->params.delay);
+    handles.adsr_attack  = Params::create("adsr_attack", this->params.attack);
+    handles.adsr_hold    = Params::create("adsr_hold", this->params.hold);
+    handles.adsr_decay   = Params::create("adsr_decay", this->params.decay);
+    handles.adsr_sustain = Params::create("adsr_sustain", this->params.sustain);
+    handles.adsr_release = Params::create("adsr_release", 1.0 / this->params.release);
+    handles.steal_policy = Params::create("steal_policy", (double)StealPolicy::release_first);
+
+    this->sustain_smoothed.init(this->sample_rate, 0.02, SmoothingType::linear);
+    this->sustain_smoothed.snap((float)this->params.sustain);
+    this->sustain_ramp.resize(Mixer::max_block_frames);
+    this->env_buffer.resize(Mixer::max_block_frames);
+    this->osc_buffer.resize(Mixer::max_block_frames);
+}
+
+WavetableOsc::~WavetableOsc() {
+    const auto& handles = this->param_handles;
+    for (const Params::Handle handle: {
+             handles.shape, handles.adsr_delay, handles.adsr_attack, handles.adsr_hold, handles.adsr_decay,
+             handles.adsr_sustain, handles.adsr_release, handles.steal_policy}) {
+        Params::destroy(handle);
+    }
+}
+
+void WavetableOsc::process_block(const size_t n_frames, float* output) {
+    const double sample_length_sec = 1.0 / this->sample_rate;
+
+    const auto& handles  = this->param_handles;
+    this->params.delay   = Params::get(handles.adsr_delay);
+    this->params.attack  = Params::get(handles.adsr_attack);
+    this->params.hold    = Params::get(handles.adsr_hold);
+    this->params.decay   = Params::get(handles.adsr_decay);
+    this->params.release = 1.0 / Params::get(handles.adsr_release);
+
+    this->sustain_smoothed.set_target((float)Params::get(handles.adsr_sustain));
+    this->sustain_smoothed.fill(this->sustain_ramp.data(), n_frames);
+
+    if (this->allocator.n_active() == 0) return;
+
+    const size_t shape     = std::min((size_t)round(Params::get(handles.shape)), (size_t)WavetableShape::n_shapes - 1);
+    const Wavetable& table = *this->tables[shape];
+
+    auto& voices          = this->voices;
+    float* env            = this->env_buffer.data();
+    float* osc            = this->osc_buffer.data();
+    const float pan_value = (float)Common::lut_panning[127] / 4095.0f;
+
+    for (size_t active_index = 0; active_index < this->allocator.active_voices.size();) {
+        const uint32_t voice_index = this->allocator.active_voices[active_index];
+
+        auto& vol_env = voices.vol_env[voice_index];
+        vol_env.render(env, n_frames, sample_length_sec, this->params, this->sustain_ramp.data());
+        const bool faded_out = this->allocator.apply_fade(voice_index, env, n_frames);
+
+        voices.phase[voice_index] = table.render(osc, n_frames, voices.phase[voice_index], voices.phase_inc[voice_index]);
+
+        const float velocity = voices.velocity[voice_index];
+        for (size_t i = 0; i < n_frames; ++i) {
+            float final_volume = velocity * env[i];
+            final_volume       = final_volume * final_volume;
+            const float sample = osc[i] * final_volume * pan_value;
+            output[2 * i + 0] += sample;
+            output[2 * i + 1] += sample;
+        }
+
+        if (vol_env.stage == VolEnvStage::idle || faded_out) {
+            this->allocator.release(active_index);
+        } else {
+            ++active_index;
+        }
+    }
+}
+
+void WavetableOsc::key_on(uint8_t key, uint8_t velocity) {
+    const StealPolicy policy = (StealPolicy)std::clamp(
+        (int)round(Params::get(this->param_handles.steal_policy)), 0, (int)StealPolicy::n_policies - 1);
+    this->allocator.begin_note();
+    const uint32_t voice_index = this->allocator.allocate(key, policy, this->voices.vol_env.data(), this->voices.key.data());
+    if (voice_index == VoiceAllocator::none) return;
+
+    const double frequency                  = Common::note_frequency((double)key + (double)this->pitch_bend_amount);
+    auto& voices                            = this->voices;
+    voices.phase[voice_index]               = 0.0;
+    voices.phase_inc[voice_index]           = frequency / this->sample_rate;
+    voices.velocity[voice_index]            = (float)velocity / 127.0f;
+    voices.key[voice_index]                 = key;
+    voices.vol_env[voice_index].stage       = VolEnvStage::delay;
+    voices.vol_env[voice_index].stage_time  = 0.0;
+    voices.vol_env[voice_index].adsr_volume = 0.0;
+}
+
+void WavetableOsc::key_off(uint8_t key) {
+    for (const uint32_t voice_index: this->allocator.active_voices) {
+        if (this->voices.key[voice_index] == key) {
+            this->voices.vol_env[voice_index].stage = VolEnvStage::release;
+        }
+    }
+}
+
+void WavetableOsc::pitch_bend(float semitones) {
+    this->pitch_bend_amount = semitones;
+    for (const uint32_t voice_index: this->allocator.active_voices) {
+        const double note                   = (double)this->voices.key[voice_index] + (double)semitones;
+        this->voices.phase_inc[voice_index] = Common::note_frequency(note) / this->sample_rate;
+    }
+}
+
+void WavetableOsc::prepare(double sample_rate) {
+    this->allocator.set_sample_rate(sample_rate);
+    this->sustain_smoothed.init(sample_rate, 0.02, SmoothingType::linear);
+    this->pitch_bend(this->pitch_bend_amount); // Recalculates the phase increments
+}
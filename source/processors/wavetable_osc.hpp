@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../processor.hpp"
+#include "../adsr.hpp"
+#include "../parameters.hpp"
+#include "../smoothed_value.hpp"
+#include "../voice_allocator.hpp"
+#include "wavetable.hpp"
+#include <memory>
+#include <vector>
+
+// Polyphonic oscillator that plays band-limited wavetables. The tables are shared, so any number of these can be created
+// without generating the tables again.
+struct WavetableOsc : Processor {
+    explicit WavetableOsc(size_t max_polyphony = 64);
+    ~WavetableOsc();
+    void process_block(const size_t n_frames, float* output) override;
+    virtual void key_on(uint8_t key, uint8_t velocity) override;
+    virtual void key_off(uint8_t key) override;
+    virtual void pitch_bend(float semitones) override;
+    virtual void prepare(double sample_rate) override;
+    size_t n_active_voices() const { return allocator.n_active(); }
+
+    // Voice state, one array per field
+    struct {
+        std::vector<VolEnv> vol_env;
+        std::vector<double> phase;     // In cycles, 0.0 to 1.0
+        std::vector<double> phase_inc; // In cycles per sample, only changes when the pitch does
+        std::vector<float> velocity;
+        std::vector<uint8_t> key;
+    } voices;
+    VoiceAllocator allocator;
+    VolEnvParams params;
+    float pitch_bend_amount = 0.0f; // In semitones
+
+    struct {
+        Params::Handle shape;
+        Params::Handle adsr_delay;
+        Params::Handle adsr_attack;
+        Params::Handle adsr_hold;
+        Params::Handle adsr_decay;
+        Params::Handle adsr_sustain;
+        Params::Handle adsr_release;
+        Params::Handle steal_policy;
+    } param_handles;
+
+    // All tables are fetched up front, so changing the shape never allocates on the audio thread
+    std::shared_ptr<const Wavetable> tables[(size_t)WavetableShape::n_shapes];
+
+    SmoothedValue sustain_smoothed;
+    std::vector<float> sustain_ramp;
+    std::vector<float> env_buffer;
+    std::vector<float> osc_buffer;
+};
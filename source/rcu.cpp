@@ -0,0 +1,50 @@
+#include "rcu.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Rcu {
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        uint64_t epoch; // Number of blocks that had started when the object was retired
+    };
+
+    // Written by the audio thread only. Blocks finish in the order they start, so once `blocks_finished` reaches the value
+    // `blocks_started` had right after a pointer was swapped out, every block that could have loaded it is done.
+    std::atomic<uint64_t> blocks_started  = 0;
+    std::atomic<uint64_t> blocks_finished = 0;
+
+    // UI thread only
+    std::vector<Retired> retired;
+
+    void begin_read() {
+        // Sequentially consistent, together with the loads and the exchange in Ptr. A block that loaded the old pointer
+        // must have bumped the counter before retire() reads it.
+        blocks_started.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void end_read() {
+        blocks_finished.store(blocks_finished.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void retire(void* object, void (*destroy)(void*)) {
+        retired.push_back({object, destroy, blocks_started.load(std::memory_order_seq_cst)});
+    }
+
+    void reclaim() {
+        const uint64_t finished = blocks_finished.load(std::memory_order_acquire);
+
+        // Take the entries out of the list before destroying them, in case a destructor retires something itself
+        std::vector<Retired> ready;
+        std::erase_if(retired, [&](const Retired& entry) {
+            if (entry.epoch > finished) return false;
+            ready.push_back(entry);
+            return true;
+        });
+        for (const auto& entry: ready) {
+            entry.destroy(entry.object);
+        }
+    }
+
+    size_t n_retired() { return retired.size(); }
+} // namespace Rcu
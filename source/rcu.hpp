@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Read-copy-update for data the audio thread reads while the UI thread replaces it. The UI thread never edits published
+// data in place: it builds a new copy, swaps it in with a single atomic exchange and retires the old one. The audio thread
+// marks the start and end of every block, and a retired copy is only deleted once every block that could have seen it has
+// finished. Readers never lock or wait, the bookkeeping all happens on the UI thread.
+//
+// There is one reader, the audio thread (together with the workers it hands jobs to during a block), and one writer, the
+// UI thread.
+namespace Rcu {
+    // Audio thread, around every block. Pointers loaded from a Ptr stay valid until end_read().
+    void begin_read();
+    void end_read();
+
+    // UI thread. `destroy` gets called on `object` from reclaim(), once the audio thread can't be using it anymore.
+    void retire(void* object, void (*destroy)(void*));
+    // Delete the retired objects that no block can still be using. Call this regularly.
+    void reclaim();
+    size_t n_retired();
+
+    template <typename T> struct Ptr {
+        // Audio thread, between begin_read() and end_read()
+        T* load() const { return this->ptr.load(std::memory_order_seq_cst); }
+
+        // UI thread. The previous object is retired, not deleted right away.
+        void publish(std::unique_ptr<T> object) {
+            T* previous = this->ptr.exchange(object.release(), std::memory_order_seq_cst);
+            if (previous != nullptr) retire(previous, [](void* retired) { delete (T*)retired; });
+        }
+
+        std::atomic<T*> ptr = nullptr;
+    };
+} // namespace Rcu
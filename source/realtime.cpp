@@ -0,0 +1,150 @@
+#include "realtime.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define REALTIME_X86
+    #include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+#endif
+#ifdef __APPLE__
+    #include <sys/sysctl.h>
+#endif
+
+namespace Realtime {
+    // SCHED_FIFO priority of the audio callback thread, the same default JACK uses
+    constexpr int audio_thread_priority = 70;
+
+    bool flush_denormals() {
+#if defined(REALTIME_X86)
+        // FTZ is bit 15 of MXCSR, DAZ is bit 6
+        _mm_setcsr(_mm_getcsr() | 0x8040);
+        return true;
+#elif defined(__aarch64__)
+        // ARM has a single flush-to-zero bit (FZ, bit 24 of FPCR), which covers both inputs and outputs
+        uint64_t fpcr;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ull << 24)));
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool request_realtime_priority(int priority_offset) {
+#if defined(_WIN32)
+        const int priority = (priority_offset == 0) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+        return SetThreadPriority(GetCurrentThread(), priority) != 0;
+#elif defined(__APPLE__)
+        // CoreAudio already runs its callback with a time constraint policy, switching it to SCHED_FIFO would be a downgrade
+        (void)priority_offset;
+        return false;
+#else
+        sched_param param    = {};
+        param.sched_priority = std::max(audio_thread_priority - priority_offset, sched_get_priority_min(SCHED_FIFO));
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+    }
+
+    bool pin_to_core(int core) {
+#if defined(_WIN32)
+        if (core >= 64) return false;
+        return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#elif defined(__linux__)
+        if (core >= CPU_SETSIZE) return false;
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(core, &cpu_set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+        // macOS only has affinity hints, which the scheduler is free to ignore
+        (void)core;
+        return false;
+#endif
+    }
+
+    ThreadStatus setup_thread(const char* name, int core, int priority_offset) {
+        ThreadStatus status;
+        status.denormals_flushed = flush_denormals();
+        status.realtime_priority = request_realtime_priority(priority_offset);
+        status.pinned            = (core >= 0) && pin_to_core(core);
+
+        char pinning[32];
+        if (status.pinned) snprintf(pinning, sizeof(pinning), "pinned to core %i", core);
+        else snprintf(pinning, sizeof(pinning), "not pinned");
+        LOG(Info, "%s thread: denormals %s, real-time priority %s, %s", name,
+            status.denormals_flushed ? "flushed to zero" : "not flushed (unsupported CPU)",
+            status.realtime_priority ? "granted" : "not granted", pinning);
+        return status;
+    }
+
+    std::vector<int> physical_cores() {
+        std::vector<int> cores;
+#if defined(_WIN32)
+        // Only the first processor group, which is all pin_to_core() can address anyway
+        DWORD size = 0;
+        GetLogicalProcessorInformation(nullptr, &size);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (infos.empty() || !GetLogicalProcessorInformation(infos.data(), &size)) return cores;
+        for (const auto& info: infos) {
+            if (info.Relationship != RelationProcessorCore || info.ProcessorMask == 0) continue;
+            int lowest = 0;
+            while ((info.ProcessorMask & ((ULONG_PTR)1 << lowest)) == 0) ++lowest;
+            cores.push_back(lowest);
+        }
+#elif defined(__linux__)
+        // A CPU is the first of its core if it's the first one in its own sibling list, e.g. "0,8" or "0-1"
+        const unsigned n_cpus = std::thread::hardware_concurrency();
+        for (unsigned cpu = 0; cpu < n_cpus; ++cpu) {
+            char path[96];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list", cpu);
+            FILE* file = fopen(path, "r");
+            if (file == nullptr) return {};
+            int first_sibling = -1;
+            const bool parsed = fscanf(file, "%i", &first_sibling) == 1;
+            fclose(file);
+            if (!parsed) return {};
+            if (first_sibling == (int)cpu) cores.push_back((int)cpu);
+        }
+#elif defined(__APPLE__)
+        // No pinning on macOS, so only the count matters
+        int n_cores       = 0;
+        size_t value_size = sizeof(n_cores);
+        if (sysctlbyname("hw.physicalcpu", &n_cores, &value_size, nullptr, 0) != 0) return cores;
+        for (int i = 0; i < n_cores; ++i) cores.push_back(i);
+#endif
+        std::sort(cores.begin(), cores.end());
+        return cores;
+    }
+
+    bool lock_memory() {
+#ifdef _WIN32
+        LOG(Info, "Memory locking is not supported on this platform, the audio thread may page fault");
+        return false;
+#else
+        // With a limited RLIMIT_MEMLOCK, also locking future pages would make allocations fail once the limit is reached
+        rlimit limit;
+        const bool unlimited = getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY;
+        if (mlockall(unlimited ? (MCL_CURRENT | MCL_FUTURE) : MCL_CURRENT) != 0) {
+            LOG(Info, "Could not lock memory (%s), the audio thread may page fault", strerror(errno));
+            return false;
+        }
+        LOG(Info, "Locked %s memory pages into RAM", unlimited ? "current and future" : "current");
+        return true;
+#endif
+    }
+} // namespace Realtime
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+
+// Setup for the threads that render audio. Every step is a request to the OS that may be denied (real-time scheduling
+// usually needs extra permissions), so each one falls back to carrying on without it, and logs what was granted.
+namespace Realtime {
+    struct ThreadStatus {
+        bool denormals_flushed = false;
+        bool realtime_priority = false;
+        bool pinned            = false;
+    };
+
+    // Flush subnormal results to zero (FTZ) and treat subnormal inputs as zero (DAZ) on the calling thread. Decaying
+    // envelopes and filter feedback otherwise end up in subnormal territory, which is very slow on x86.
+    bool flush_denormals();
+    // Prepare the calling thread for rendering audio: flush denormals, ask for real-time scheduling and pin it to `core`
+    // (-1 leaves it on any core). `priority_offset` lowers the priority relative to the audio callback thread. Call this
+    // once, when the thread starts.
+    ThreadStatus setup_thread(const char* name, int core, int priority_offset = 0);
+    // One logical CPU index per physical core, the lowest of its hyperthreads, in ascending order. Pinning threads to these
+    // keeps them off each other's sibling hyperthreads. Empty if the OS doesn't tell us.
+    std::vector<int> physical_cores();
+    // Lock the pages the process currently has, and if the OS allows it all future ones too, into RAM, so the audio thread
+    // never waits for a page fault. Call this once the engine has been set up.
+    bool lock_memory();
+} // namespace Realtime
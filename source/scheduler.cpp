@@ -0,0 +1,213 @@
+#include "scheduler.hpp"
+#include "log.hpp"
+#include "realtime.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #include <immintrin.h>
+#endif
+
+namespace Scheduler {
+    constexpr size_t max_threads = 64;
+    constexpr size_t max_jobs    = 0xFFFF;
+
+    // Each thread owns a range of job indices. The range is packed into a single atomic together with the generation it
+    // belongs to: [generation:32][begin:16][end:16]. The owner takes jobs from the front, thieves take them from the back,
+    // and both do so with a compare-exchange on the whole word. Tagging with the generation stops a worker that fell
+    // behind from taking jobs out of the next block with a stale view of it.
+    struct alignas(64) JobQueue {
+        std::atomic<uint64_t> range = 0;
+    };
+
+    struct WorkerPool {
+        ~WorkerPool() { shutdown(); }
+
+        JobQueue queues[max_threads];
+        std::vector<std::thread> threads;
+        size_t n_participants = 1;
+        std::vector<int> cores; // Logical CPU to pin each thread to, one per physical core. Written before the workers start
+
+        std::atomic<bool> running          = false;
+        std::atomic<uint32_t> generation   = 0;
+        std::atomic<JobFunc> job_func      = nullptr;
+        std::atomic<void*> job_user_data   = nullptr;
+        std::atomic<size_t> jobs_remaining = 0;
+    } pool;
+
+    uint64_t pack_range(uint32_t generation, uint64_t begin, uint64_t end) {
+        return ((uint64_t)generation << 32) | (begin << 16) | end;
+    }
+
+    void cpu_relax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    // Spin for a while, then start yielding. Only once the pool has been idle for a long time (audio stopped) do we
+    // actually sleep, so we don't keep a core busy forever. Yielding only hands the core to threads of the same priority,
+    // so threads with real-time priority take short naps instead, to let the rest of the system run. After about 100 ms of
+    // those they fall back to the long sleep too, instead of waking up 20000 times a second while nothing is playing.
+    void backoff(size_t n_idle_spins, bool realtime) {
+        constexpr size_t n_spins     = 4096;
+        constexpr size_t n_yields    = 262144 - n_spins;
+        constexpr size_t n_rt_naps   = 2048;
+        const size_t long_idle_spins = n_spins + (realtime ? n_rt_naps : n_yields);
+        if (n_idle_spins < n_spins) cpu_relax();
+        else if (n_idle_spins >= long_idle_spins) std::this_thread::sleep_for(std::chrono::microseconds(500));
+        else if (realtime) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        else std::this_thread::yield();
+    }
+
+    bool pop_front(size_t queue_index, uint32_t generation, size_t& job) {
+        auto& range    = pool.queues[queue_index].range;
+        uint64_t value = range.load(std::memory_order_acquire);
+        while (true) {
+            const uint64_t begin = (value >> 16) & 0xFFFF;
+            const uint64_t end   = value & 0xFFFF;
+            if ((uint32_t)(value >> 32) != generation || begin >= end) return false;
+            if (range.compare_exchange_weak(value, pack_range(generation, begin + 1, end), std::memory_order_acq_rel)) {
+                job = (size_t)begin;
+                return true;
+            }
+        }
+    }
+
+    bool steal_back(size_t queue_index, uint32_t generation, size_t& job) {
+        auto& range    = pool.queues[queue_index].range;
+        uint64_t value = range.load(std::memory_order_acquire);
+        while (true) {
+            const uint64_t begin = (value >> 16) & 0xFFFF;
+            const uint64_t end   = value & 0xFFFF;
+            if ((uint32_t)(value >> 32) != generation || begin >= end) return false;
+            if (range.compare_exchange_weak(value, pack_range(generation, begin, end - 1), std::memory_order_acq_rel)) {
+                job = (size_t)(end - 1);
+                return true;
+            }
+        }
+    }
+
+    void run_job(size_t job) {
+        const JobFunc func = pool.job_func.load(std::memory_order_relaxed);
+        func(job, pool.job_user_data.load(std::memory_order_relaxed));
+        pool.jobs_remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    // Run jobs until there are none left to take, first from our own queue, then from everyone else's
+    void work(size_t self, uint32_t generation) {
+        size_t job;
+        while (true) {
+            if (pop_front(self, generation, job)) {
+                run_job(job);
+                continue;
+            }
+
+            bool stole_job = false;
+            for (size_t i = 1; i < pool.n_participants; ++i) {
+                const size_t victim = (self + i) % pool.n_participants;
+                if (steal_back(victim, generation, job)) {
+                    run_job(job);
+                    stole_job = true;
+                    break;
+                }
+            }
+            if (!stole_job) return;
+        }
+    }
+
+    void worker_main(size_t self) {
+        // Thread 0 is the audio callback, which pins itself to core 0, so each worker gets the physical core matching its
+        // index. Pinning to logical CPU `self` could put two workers on the hyperthreads of one core.
+        char name[32];
+        snprintf(name, sizeof(name), "Audio worker %zu", self);
+        const int core                      = (self < pool.cores.size()) ? pool.cores[self] : (int)self;
+        const Realtime::ThreadStatus status = Realtime::setup_thread(name, core, 1);
+
+        uint32_t seen_generation = pool.generation.load(std::memory_order_acquire);
+        size_t n_idle_spins      = 0;
+
+        while (pool.running.load(std::memory_order_relaxed)) {
+            const uint32_t generation = pool.generation.load(std::memory_order_acquire);
+            if (generation != seen_generation) {
+                seen_generation = generation;
+                work(self, generation);
+                n_idle_spins = 0;
+                continue;
+            }
+            backoff(n_idle_spins++, status.realtime_priority);
+        }
+    }
+
+    void init(size_t n_threads) {
+        if (pool.running.load()) return;
+
+        // Hyperthreads share a core's execution units, so a second spinning worker on the same core only takes time away
+        // from the first one. Only if the core layout is unknown do we go by the logical CPU count.
+        pool.cores = Realtime::physical_cores();
+        if (n_threads == 0 && !pool.cores.empty()) n_threads = pool.cores.size();
+        if (n_threads == 0) n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        n_threads = std::min(n_threads, max_threads);
+
+        pool.n_participants = n_threads;
+        pool.running.store(true);
+
+        // Thread 0 is whoever calls run(), usually the audio callback
+        for (size_t i = 1; i < n_threads; ++i) {
+            pool.threads.emplace_back(worker_main, i);
+        }
+
+        LOG(Info, "Audio scheduler running on %zu thread(s)", n_threads);
+    }
+
+    void shutdown() {
+        pool.running.store(false);
+        for (auto& thread: pool.threads) {
+            if (thread.joinable()) thread.join();
+        }
+        pool.threads.clear();
+        pool.n_participants = 1;
+    }
+
+    size_t n_threads() { return pool.n_participants; }
+
+    void run(size_t n_jobs, JobFunc func, void* user_data) {
+        if (n_jobs == 0) return;
+
+        // Not worth waking anyone up for
+        if (pool.n_participants == 1 || n_jobs == 1 || n_jobs > max_jobs) {
+            for (size_t i = 0; i < n_jobs; ++i) func(i, user_data);
+            return;
+        }
+
+        const uint32_t generation = pool.generation.load(std::memory_order_relaxed) + 1;
+        pool.job_func.store(func, std::memory_order_relaxed);
+        pool.job_user_data.store(user_data, std::memory_order_relaxed);
+        pool.jobs_remaining.store(n_jobs, std::memory_order_relaxed);
+
+        // Hand every thread an equal share up front, stealing evens out whatever imbalance is left
+        const size_t n_participants = pool.n_participants;
+        for (size_t i = 0; i < n_participants; ++i) {
+            const uint64_t begin = (n_jobs * i) / n_participants;
+            const uint64_t end   = (n_jobs * (i + 1)) / n_participants;
+            pool.queues[i].range.store(pack_range(generation, begin, end), std::memory_order_release);
+        }
+        pool.generation.store(generation, std::memory_order_release);
+
+        work(0, generation);
+
+        size_t n_spins = 0;
+        while (pool.jobs_remaining.load(std::memory_order_acquire) != 0) {
+            if (n_spins++ < 4096) cpu_relax();
+            else std::this_thread::yield();
+        }
+    }
+} // namespace Scheduler
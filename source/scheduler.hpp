@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+// Pool of worker threads used to spread the audio processing of a block over multiple cores. Workers spin while waiting for
+// work instead of sleeping on a condition variable, so waking them up costs nothing on the audio thread.
+namespace Scheduler {
+    using JobFunc = void (*)(size_t job_index, void* user_data);
+
+    // Start the worker threads. With n_threads == 0, one thread per physical core is used, including the caller of run().
+    void init(size_t n_threads = 0);
+    void shutdown();
+    // Number of threads that participate in run(), including the calling thread
+    size_t n_threads();
+
+    // Call `func` once for every job index in [0, n_jobs), spread over the workers and the calling thread. Jobs are split
+    // evenly up front, threads that run out of jobs steal from the others. Returns once every job has finished.
+    void run(size_t n_jobs, JobFunc func, void* user_data);
+} // namespace Scheduler
@@ -1,14 +1,36 @@
 #include "session.hpp"
+#include "mixer.hpp"
+#include "rcu.hpp"
 
 namespace Session {
     struct {
-        std::vector<Track> tracks;
+        std::vector<std::shared_ptr<Track>> tracks;
     } data;
 
-    size_t create_track() {
-        data.tracks.emplace_back(Track{});
+    Rcu::Ptr<TrackList> audio_track_list;
+
+    // The audio thread only ever sees complete snapshots, the list it's iterating is never modified
+    void publish_tracks() {
+        audio_track_list.publish(std::make_unique<TrackList>(TrackList{data.tracks}));
+        Rcu::reclaim();
+    }
+
+    size_t create_track() { return add_track(std::make_shared<Track>()); }
+
+    size_t add_track(std::shared_ptr<Track> track) {
+        data.tracks.push_back(std::move(track));
+        publish_tracks();
         return data.tracks.size() - 1;
     }
 
-    std::vector<Track>& tracks() { return data.tracks; }
+    void remove_track(size_t index) {
+        if (index >= data.tracks.size()) return;
+        Mixer::remove_node(data.tracks[index]->mixer_node);
+        data.tracks.erase(data.tracks.begin() + index);
+        publish_tracks();
+    }
+
+    const std::vector<std::shared_ptr<Track>>& tracks() { return data.tracks; }
+
+    const TrackList* audio_tracks() { return audio_track_list.load(); }
 }; // namespace Session
@@ -1,8 +1,20 @@
 #pragma once
 #include "track.hpp"
+#include <memory>
 #include <vector>
 
 namespace Session {
+    // Snapshot of the tracks, published to the audio thread whenever a track is added or removed
+    struct TrackList {
+        std::vector<std::shared_ptr<Track>> tracks;
+    };
+
+    // UI thread, not real-time safe
     size_t create_track();
-    std::vector<Track>& tracks();
-} // namespace Session
\ No newline at end of file
+    size_t add_track(std::shared_ptr<Track> track);
+    void remove_track(size_t index);
+    const std::vector<std::shared_ptr<Track>>& tracks();
+
+    // Audio thread, between Rcu::begin_read() and Rcu::end_read()
+    const TrackList* audio_tracks();
+} // namespace Session
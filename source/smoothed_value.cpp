@@ -0,0 +1,70 @@
+#include "smoothed_value.hpp"
+#include <cmath>
+#include <algorithm>
+
+void SmoothedValue::init(double sample_rate, double ramp_time, SmoothingType smoothing_type) {
+    this->type         = smoothing_type;
+    this->ramp_samples = std::max((uint32_t)(sample_rate * ramp_time), 1u);
+    this->coef         = (float)pow(0.001, 1.0 / (double)this->ramp_samples);
+    this->snap(this->target);
+}
+
+void SmoothedValue::set_target(float new_target) {
+    if (new_target == this->target) return;
+
+    this->target       = new_target;
+    this->n_steps_left = this->ramp_samples;
+    this->step         = (this->target - this->current) / (float)this->ramp_samples;
+}
+
+void SmoothedValue::snap(float value) {
+    this->current      = value;
+    this->target       = value;
+    this->step         = 0.0f;
+    this->n_steps_left = 0;
+}
+
+void SmoothedValue::fill(float* ramp, size_t n_samples) {
+    const size_t n_moving = std::min((size_t)this->n_steps_left, n_samples);
+
+    if (n_moving > 0 && this->type == SmoothingType::linear) {
+        // Every sample is computed from the start value rather than accumulated, so the loop has no dependency chain and
+        // the compiler can vectorize it
+        const float start = this->current;
+        const float step  = this->step;
+        for (size_t i = 0; i < n_moving; ++i) {
+            ramp[i] = start + step * (float)(i + 1);
+        }
+    } else if (n_moving > 0 && this->type == SmoothingType::exponential) {
+        // Split the decay into 8 lanes that each advance by coef^8, again so there's no dependency between neighbours
+        constexpr size_t n_lanes = 8;
+        float lane_gain[n_lanes];
+        float gain = this->coef;
+        for (size_t lane = 0; lane < n_lanes; ++lane) {
+            lane_gain[lane] = gain;
+            gain *= this->coef;
+        }
+        const float stride_gain = lane_gain[n_lanes - 1];
+        const float distance    = this->current - this->target;
+
+        float block_gain = 1.0f;
+        size_t i         = 0;
+        for (; i + n_lanes <= n_moving; i += n_lanes) {
+            for (size_t lane = 0; lane < n_lanes; ++lane) {
+                ramp[i + lane] = this->target + distance * block_gain * lane_gain[lane];
+            }
+            block_gain *= stride_gain;
+        }
+        for (size_t lane = 0; i < n_moving; ++i, ++lane) {
+            ramp[i] = this->target + distance * block_gain * lane_gain[lane];
+        }
+    }
+
+    if (n_moving > 0) {
+        this->n_steps_left -= (uint32_t)n_moving;
+        this->current = (this->n_steps_left == 0) ? this->target : ramp[n_moving - 1];
+    }
+
+    // Whatever is left of the block sits at the target
+    std::fill(ramp + n_moving, ramp + n_samples, this->current);
+}
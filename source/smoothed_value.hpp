@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+enum class SmoothingType {
+    linear = 0,  // Reaches the target in a fixed amount of time
+    exponential, // One-pole style approach, `ramp_time` is the time it takes to get 99.9% of the way there
+};
+
+// Parameter value that glides to new targets instead of jumping, to avoid zipper noise. Instead of being ticked per
+// sample, it writes the values for a whole block into a buffer in one go, which the processor can then read from.
+struct SmoothedValue {
+    void init(double sample_rate, double ramp_time, SmoothingType smoothing_type = SmoothingType::linear);
+    void set_target(float new_target);
+    // Jump to a value immediately
+    void snap(float value);
+    bool is_smoothing() const { return n_steps_left > 0; }
+
+    // Write the next `n_samples` values to `ramp`
+    void fill(float* ramp, size_t n_samples);
+
+    float current         = 0.0f;
+    float target          = 0.0f;
+    float step            = 0.0f; // Per-sample increment for linear smoothing
+    float coef            = 0.0f; // Per-sample decay for exponential smoothing
+    uint32_t n_steps_left = 0;
+    uint32_t ramp_samples = 1;
+    SmoothingType type    = SmoothingType::linear;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity single-producer/single-consumer ring buffer. Both sides are wait-free and never allocate, so it is safe to
+// use from driver callbacks and the audio thread. Capacity has to be a power of two.
+template <typename T, size_t Capacity> struct SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    // Producer side. Returns false and bumps the overflow counter if the ring is full.
+    bool push(const T& value) {
+        const size_t write = write_index.load(std::memory_order_relaxed);
+        const size_t read  = read_index.load(std::memory_order_acquire);
+        if (write - read >= Capacity) {
+            n_overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[write & (Capacity - 1)] = value;
+        write_index.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side. Pushes all `n` values or none of them, so a block never gets split. Returns false and bumps the overflow
+    // counter if they don't fit.
+    bool push(const T* values, size_t n) {
+        const size_t write = write_index.load(std::memory_order_relaxed);
+        const size_t read  = read_index.load(std::memory_order_acquire);
+        if (Capacity - (write - read) < n) {
+            n_overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            items[(write + i) & (Capacity - 1)] = values[i];
+        }
+        write_index.store(write + n, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns a pointer to the oldest item without removing it, or nullptr if the ring is empty.
+    T* peek() {
+        const size_t read  = read_index.load(std::memory_order_relaxed);
+        const size_t write = write_index.load(std::memory_order_acquire);
+        if (read == write) return nullptr;
+        return &items[read & (Capacity - 1)];
+    }
+
+    // Consumer side. Removes the oldest item, copying it to `value`. Returns false if the ring is empty.
+    bool pop(T& value) {
+        T* front = peek();
+        if (front == nullptr) return false;
+        value = *front;
+        read_index.store(read_index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Removes up to `n` of the oldest items, copying them to `values`. Returns how many were removed.
+    size_t pop(T* values, size_t n) {
+        const size_t read  = read_index.load(std::memory_order_relaxed);
+        const size_t write = write_index.load(std::memory_order_acquire);
+        n                  = std::min(n, write - read);
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = items[(read + i) & (Capacity - 1)];
+        }
+        read_index.store(read + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side. Removes the oldest item, assuming there is one.
+    void drop_front() { read_index.store(read_index.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    bool empty() const {
+        return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        // Load the read index first, the write index can only have moved further ahead since then
+        const size_t read = read_index.load(std::memory_order_acquire);
+        return write_index.load(std::memory_order_acquire) - read;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    // Number of items that were rejected by push() because the ring was full
+    std::atomic<uint64_t> n_overflows = 0;
+
+  private:
+    // Indices only ever increase, the slot is `index & (Capacity - 1)`. Keep them on separate cache lines so the producer and
+    // consumer don't fight over the same line.
+    alignas(64) std::atomic<size_t> write_index = 0;
+    alignas(64) std::atomic<size_t> read_index  = 0;
+    alignas(64) T items[Capacity]{};
+};
@@ -0,0 +1,36 @@
+#include "timing_stats.hpp"
+#include <algorithm>
+#include <bit>
+
+void TimingStats::record(int64_t duration_ns) {
+    // There is only one writer, so plain loads and stores are enough, no read-modify-write needed
+    if (this->reset_requested.exchange(false, std::memory_order_relaxed)) {
+        this->n_measurements.store(0, std::memory_order_relaxed);
+        this->total_ns.store(0, std::memory_order_relaxed);
+        this->min_ns.store(UINT64_MAX, std::memory_order_relaxed);
+        this->max_ns.store(0, std::memory_order_relaxed);
+        for (auto& bin: this->histogram) bin.store(0, std::memory_order_relaxed);
+    }
+
+    const uint64_t duration = (duration_ns > 0) ? (uint64_t)duration_ns : 0;
+    const size_t bin        = std::min((size_t)std::bit_width(duration / 1000), n_histogram_bins - 1);
+    this->histogram[bin].store(this->histogram[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    this->total_ns.store(this->total_ns.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+    if (duration < this->min_ns.load(std::memory_order_relaxed)) this->min_ns.store(duration, std::memory_order_relaxed);
+    if (duration > this->max_ns.load(std::memory_order_relaxed)) this->max_ns.store(duration, std::memory_order_relaxed);
+    this->n_measurements.store(this->n_measurements.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+TimingStats::Snapshot TimingStats::snapshot() const {
+    Snapshot result;
+    result.n_measurements = this->n_measurements.load(std::memory_order_acquire);
+    if (result.n_measurements == 0) return result;
+
+    result.min_us = (double)this->min_ns.load(std::memory_order_relaxed) / 1000.0;
+    result.max_us = (double)this->max_ns.load(std::memory_order_relaxed) / 1000.0;
+    result.avg_us = (double)this->total_ns.load(std::memory_order_relaxed) / 1000.0 / (double)result.n_measurements;
+    for (size_t i = 0; i < n_histogram_bins; ++i) {
+        result.histogram[i] = this->histogram[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
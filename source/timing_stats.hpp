@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Duration statistics that one thread records into while any other thread reads them, without locks. A reader can see a
+// measurement that's only partly added, which is fine for monitoring.
+struct TimingStats {
+    // Bin 0 counts everything under 1 us, bin `i` after that covers [2^(i-1), 2^i) us. The last bin also counts everything
+    // longer than that.
+    static constexpr size_t n_histogram_bins = 24;
+
+    struct Snapshot {
+        uint64_t n_measurements = 0;
+        double min_us           = 0.0;
+        double avg_us           = 0.0;
+        double max_us           = 0.0;
+        uint64_t histogram[n_histogram_bins]{};
+    };
+
+    // Only call this from one thread at a time
+    void record(int64_t duration_ns);
+    // Can be called from any thread. The stats get cleared right before the next measurement is recorded.
+    void request_reset() { reset_requested.store(true, std::memory_order_relaxed); }
+    Snapshot snapshot() const;
+
+    std::atomic<uint64_t> n_measurements = 0;
+    std::atomic<uint64_t> total_ns       = 0;
+    std::atomic<uint64_t> min_ns         = UINT64_MAX;
+    std::atomic<uint64_t> max_ns         = 0;
+    std::atomic<uint64_t> histogram[n_histogram_bins]{};
+    std::atomic<bool> reset_requested    = false;
+};
@@ -1,36 +1,34 @@
 #include "track.hpp"
-#include "log.hpp"
 #include "mixer.hpp"
 
-Track::Track() {
-    this->debug_processor = std::make_shared<WavOsc>();
-    Mixer::register_processor(this->debug_processor);
-}
+Track::Track() : Track(std::make_shared<WavOsc>()) {}
 
-void Track::midi_note_on(int channel, uint8_t key, uint8_t velocity) {
-    LOG(Debug, "[Channel %2i] Note On: key %i, velocity %i", channel, key, velocity);
-    this->debug_processor->key_on(key, velocity);
+Track::Track(std::shared_ptr<Processor> processor, size_t oversampling) {
+    if (oversampling > 1) processor = std::make_shared<Oversampler>(std::move(processor), oversampling);
+    this->debug_processor = std::move(processor);
+    this->mixer_node      = Mixer::register_processor(this->debug_processor);
 }
 
-void Track::midi_note_off(int channel, uint8_t key, uint8_t velocity) {
-    LOG(Debug, "[Channel %2i] Note Off: key %i, velocity %i", channel, key, velocity);
-    this->debug_processor->key_off(key);
+// These get called on the audio thread by Midi::process(), so they must not log, lock or allocate. Incoming messages
+// are logged on the RtMidi thread instead, before they get queued.
+void Track::midi_note_on(int channel, uint8_t key, uint8_t velocity, uint64_t sample_position) {
+    this->debug_processor->queue_event({sample_position, NoteEventType::key_on, key, velocity});
 }
 
-void Track::midi_poly_aftertouch(int channel, uint8_t key, uint8_t pressure) {
-    LOG(Debug, "[Channel %2i] Polyphonic Aftertouch: key %i, pressure %i", channel, key, pressure);
+void Track::midi_note_off(int channel, uint8_t key, uint8_t velocity, uint64_t sample_position) {
+    this->debug_processor->queue_event({sample_position, NoteEventType::key_off, key, velocity});
 }
 
-void Track::midi_control_change(int channel, uint8_t id, uint8_t value) {
-    LOG(Debug, "[Channel %2i] Control Change: controller %i, data %i", channel, id, value);
-}
+void Track::midi_poly_aftertouch(int channel, uint8_t key, uint8_t pressure) {}
 
-void Track::midi_program_change(int channel, uint8_t program) {
-    LOG(Debug, "[Channel %2i] Program Change: program %i", channel, program);
-}
+void Track::midi_control_change(int channel, uint8_t id, uint8_t value) {}
 
-void Track::midi_channel_aftertouch(int channel, uint8_t pressure) {
-    LOG(Debug, "[Channel %2i] Channel Aftertouch: pressure %i", channel, pressure);
-}
+void Track::midi_program_change(int channel, uint8_t program) {}
+
+void Track::midi_channel_aftertouch(int channel, uint8_t pressure) {}
 
-void Track::midi_pitch_wheel(int channel, uint16_t value) { LOG(Debug, "[Channel %2i] Pitch Wheel: %i", channel, value); }
+void Track::midi_pitch_wheel(int channel, uint16_t value, uint64_t sample_position) {
+    // The wheel is 14 bits, centered at 8192
+    const double semitones = ((double)value - 8192.0) / 8192.0 * (this->pitch_wheel_range_cents / 100.0);
+    this->debug_processor->queue_event({sample_position, NoteEventType::pitch_bend, 0, 0, (float)semitones});
+}
@@ -1,19 +1,24 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include "audio_graph.hpp"
 #include "processors/wav_osc.hpp"
+#include "processors/oversampler.hpp"
 
 struct Track {
-    uint16_t midi_input_channel_mask        = 1;
-    double pitch_wheel_range_cents          = 200.0;
-    std::shared_ptr<WavOsc> debug_processor = nullptr;
+    uint16_t midi_input_channel_mask           = 1;
+    double pitch_wheel_range_cents             = 200.0;
+    std::shared_ptr<Processor> debug_processor = nullptr;
+    AudioGraph::NodeID mixer_node              = AudioGraph::master;
 
     Track();
-    void midi_note_on(int channel, uint8_t key, uint8_t velocity);
-    void midi_note_off(int channel, uint8_t key, uint8_t velocity);
+    // With an `oversampling` factor of 2 or 4 the processor runs at that multiple of the output sample rate
+    explicit Track(std::shared_ptr<Processor> processor, size_t oversampling = 1);
+    void midi_note_on(int channel, uint8_t key, uint8_t velocity, uint64_t sample_position);
+    void midi_note_off(int channel, uint8_t key, uint8_t velocity, uint64_t sample_position);
     void midi_poly_aftertouch(int channel, uint8_t key, uint8_t pressure);
     void midi_control_change(int channel, uint8_t id, uint8_t value);
     void midi_program_change(int channel, uint8_t program);
     void midi_channel_aftertouch(int channel, uint8_t pressure);
-    void midi_pitch_wheel(int channel, uint16_t value);
+    void midi_pitch_wheel(int channel, uint16_t value, uint64_t sample_position);
 };
@@ -166,6 +166,30 @@ namespace UI {
         glm::vec4 color_outer = {1.0f, 1.0f, 1.0f, 1.0f};
         float thickness       = 2.0f;
     };
+    // Stereo level meter. The levels are linear amplitudes, read from three values that each hold the left and right channel
+    // as a glm::vec2. The bars span `min_db` to `max_db`.
+    struct Meter {
+        std::string peak_variable;
+        std::string rms_variable;
+        std::string hold_variable;
+        float min_db = -60.0f;
+        float max_db = 6.0f;
+    };
+    // Waveform, read from a std::vector<float> bound to the component's value with ValuePool::set_ptr. Samples at +-`range`
+    // touch the edges.
+    struct Scope {
+        float range = 1.0f;
+    };
+    // Magnitude spectrum on a logarithmic frequency axis. Reads the magnitude of every FFT bin from DC up in dB from a
+    // std::vector<float> bound to the component's value with ValuePool::set_ptr, and the width of a bin in Hz from the
+    // double `<name>_bin_hz`.
+    struct Spectrum {
+        std::string bin_hz_variable;
+        float min_hz = 20.0f;
+        float max_hz = 20000.0f;
+        float min_db = -100.0f;
+        float max_db = 0.0f;
+    };
     struct Function {
         Function(std::function<void()> click) { on_click = std::move(click); }
         std::function<void()> on_click;
@@ -229,6 +253,19 @@ namespace UI {
         return entity;
     }
 
+    // Read-only number, for showing values that the program updates, like the DSP load
+    inline EntityID create_readout(
+        Scene& scene, const std::string& name, const UI::Transform& transform, const uint32_t visual_decimal_places = 1,
+        const Text& text = {L"", {2, 2}, {1, 1, 1, 1}, Gfx::AnchorPoint::Left, Gfx::AnchorPoint::Left}) {
+        const EntityID entity = scene.new_entity();
+        scene.add_component<UI::Transform>(entity, transform);
+        scene.add_component<Value>(entity, {name, VarType::float64, scene.value_pool});
+        scene.add_component<NumberRange>(entity, {.visual_decimal_places = visual_decimal_places});
+        scene.add_component<Text>(entity, text);
+        scene.get_component<Value>(entity)->set<double>(0.0);
+        return entity;
+    }
+
     inline EntityID create_wheelknob(
         Scene& scene, const std::string& name, const UI::Transform& transform,
         const NumberRange& range = {0.0, 100.0, 1.0, 0.0, 0},
@@ -347,6 +384,42 @@ namespace UI {
         return entity;
     }
 
+    // Level meter that reads the values `<name>_peak`, `<name>_rms` and `<name>_hold`. It's vertical unless it's wider than
+    // it is tall.
+    inline EntityID create_meter(
+        Scene& scene, const std::string& name, const UI::Transform& transform, const float min_db = -60.0f,
+        const float max_db = 6.0f) {
+        const EntityID entity = scene.new_entity();
+        scene.add_component<UI::Transform>(entity, transform);
+        scene.add_component<Meter>(entity, {name + "_peak", name + "_rms", name + "_hold", min_db, max_db});
+        scene.value_pool.set_value(name + "_peak", glm::vec2(0.0f));
+        scene.value_pool.set_value(name + "_rms", glm::vec2(0.0f));
+        scene.value_pool.set_value(name + "_hold", glm::vec2(0.0f));
+        return entity;
+    }
+
+    inline EntityID
+    create_scope(Scene& scene, const std::string& name, const UI::Transform& transform, const float range = 1.0f) {
+        const EntityID entity = scene.new_entity();
+        scene.add_component<UI::Transform>(entity, transform);
+        scene.add_component<Value>(entity, {name, VarType::none, scene.value_pool});
+        scene.add_component<Scope>(entity, {range});
+        scene.value_pool.set_ptr<std::vector<float>>(name, nullptr);
+        return entity;
+    }
+
+    inline EntityID create_spectrum(
+        Scene& scene, const std::string& name, const UI::Transform& transform, const float min_hz = 20.0f,
+        const float max_hz = 20000.0f, const float min_db = -100.0f, const float max_db = 0.0f) {
+        const EntityID entity = scene.new_entity();
+        scene.add_component<UI::Transform>(entity, transform);
+        scene.add_component<Value>(entity, {name, VarType::none, scene.value_pool});
+        scene.add_component<Spectrum>(entity, {name + "_bin_hz", min_hz, max_hz, min_db, max_db});
+        scene.value_pool.set_ptr<std::vector<float>>(name, nullptr);
+        scene.value_pool.set_value(name + "_bin_hz", 0.0);
+        return entity;
+    }
+
     inline EntityID create_box(Scene& scene, const UI::Transform& transform, const Box& box) {
         const EntityID entity = scene.new_entity();
         scene.add_component<UI::Transform>(entity, transform);
@@ -571,6 +644,210 @@ namespace UI {
             }
         }
 
+        // Level meters
+        for (const auto entity: scene.view<UI::Transform, Meter>()) {
+            auto* transform = scene.get_component<UI::Transform>(entity);
+            auto* meter     = scene.get_component<Meter>(entity);
+
+            const glm::vec2 top_left = Gfx::anchor_offset_pixels(transform->top_left, transform->anchor, scene.panel_size);
+            const glm::vec2 bottom_right =
+                Gfx::anchor_offset_pixels(transform->bottom_right, transform->anchor, scene.panel_size);
+            const glm::vec2 size     = bottom_right - top_left;
+            const bool is_horizontal = size.x > size.y;
+            const glm::vec2 peak     = scene.value_pool.get<glm::vec2>(meter->peak_variable);
+            const glm::vec2 rms      = scene.value_pool.get<glm::vec2>(meter->rms_variable);
+            const glm::vec2 hold     = scene.value_pool.get<glm::vec2>(meter->hold_variable);
+
+            // Where a level lands on the bar, from 0 at min_db to 1 at max_db
+            const auto db_to_position = [&](const float db) {
+                return std::clamp((db - meter->min_db) / (meter->max_db - meter->min_db), 0.0f, 1.0f);
+            };
+            const auto level_to_position = [&](const float level) {
+                return db_to_position(20.0f * log10f(std::max(level, 1e-6f)));
+            };
+            // Each channel gets half of the meter, with a pixel of space between them. Positions run from the bottom up, or
+            // from left to right for horizontal meters.
+            const auto draw_bar = [&](const int channel, const float from, const float to, const Color color, float depth) {
+                glm::vec2 tl, br;
+                if (is_horizontal) {
+                    tl = {top_left.x + size.x * from, top_left.y + size.y * 0.5f * (float)channel};
+                    br = {top_left.x + size.x * to, top_left.y + size.y * 0.5f * (float)(channel + 1) - 1.0f};
+                } else {
+                    tl = {top_left.x + size.x * 0.5f * (float)channel, bottom_right.y - size.y * to};
+                    br = {top_left.x + size.x * 0.5f * (float)(channel + 1) - 1.0f, bottom_right.y - size.y * from};
+                }
+                Gfx::draw_rectangle_2d_pixels(
+                    tl, br, {.color = color, .depth = depth, .anchor_point = Gfx::AnchorPoint::TopLeft});
+            };
+
+            // The RMS level is the solid bar, the peak the dimmer part above it, and the peak hold a thin line. They turn
+            // yellow in the last 6 dB below full scale, and red once the signal has clipped.
+            const float yellow_from = db_to_position(-6.0f);
+            const float hold_width  = 2.0f / std::max(is_horizontal ? size.x : size.y, 1.0f);
+            for (int channel = 0; channel < 2; ++channel) {
+                const float rms_position  = level_to_position(rms[channel]);
+                const float peak_position = std::max(level_to_position(peak[channel]), rms_position);
+                const float hold_position = std::max(level_to_position(hold[channel]), peak_position);
+                Color color               = Colors::GREEN;
+                if (peak_position >= yellow_from) color = Colors::YELLOW;
+                if (hold[channel] >= 1.0f) color = Colors::RED;
+                const Color dim_color = Color(glm::vec3(color) * 0.5f, 1.0f);
+
+                draw_bar(channel, 0.0f, 1.0f, Color(0.05f, 0.05f, 0.05f, 1.0f), transform->depth + 0.003f);
+                draw_bar(channel, rms_position, peak_position, dim_color, transform->depth + 0.002f);
+                draw_bar(channel, 0.0f, rms_position, color, transform->depth + 0.001f);
+                if (hold_position > 0.0f) {
+                    const float hold_start = std::max(hold_position - hold_width, 0.0f);
+                    draw_bar(channel, hold_start, hold_position, Colors::WHITE, transform->depth);
+                }
+            }
+        }
+
+        // Scopes
+        for (const auto entity: scene.view<UI::Transform, Value, Scope>()) {
+            auto* transform = scene.get_component<UI::Transform>(entity);
+            auto* value     = scene.get_component<Value>(entity);
+            auto* scope     = scene.get_component<Scope>(entity);
+
+            const glm::vec2 top_left = Gfx::anchor_offset_pixels(transform->top_left, transform->anchor, scene.panel_size);
+            const glm::vec2 bottom_right =
+                Gfx::anchor_offset_pixels(transform->bottom_right, transform->anchor, scene.panel_size);
+            const glm::vec2 size = bottom_right - top_left;
+            const float center_y = (top_left.y + bottom_right.y) / 2.0f;
+
+            Gfx::draw_rectangle_2d_pixels(
+                top_left, bottom_right,
+                {
+                    .color        = Color(0.05f, 0.05f, 0.05f, 1.0f),
+                    .depth        = transform->depth + 0.002f,
+                    .anchor_point = Gfx::AnchorPoint::TopLeft,
+                });
+            Gfx::draw_line_2d_pixels(
+                {top_left.x, center_y}, {bottom_right.x, center_y},
+                {
+                    .color        = Colors::DARK_GREY,
+                    .depth        = transform->depth + 0.001f,
+                    .anchor_point = Gfx::AnchorPoint::TopLeft,
+                    .line_width   = 1.0f,
+                });
+
+            const auto* samples = value->get_as_ptr<std::vector<float>>();
+            if (samples == nullptr || samples->empty()) continue;
+
+            // A vertical line per pixel column, from the lowest to the highest sample that lands in it. The last sample of
+            // the column before counts too, so the columns join up.
+            const auto sample_to_y = [&](const float sample) {
+                return center_y - std::clamp(sample / scope->range, -1.0f, 1.0f) * size.y * 0.5f;
+            };
+            const size_t n_samples = samples->size();
+            const size_t n_columns = (size_t)std::max(size.x, 1.0f);
+            float previous         = (*samples)[0];
+            for (size_t column = 0; column < n_columns; ++column) {
+                const size_t begin = std::min(column * n_samples / n_columns, n_samples - 1);
+                const size_t end   = std::max((column + 1) * n_samples / n_columns, begin + 1);
+                float low          = previous;
+                float high         = previous;
+                for (size_t i = begin; i < end; ++i) {
+                    low  = std::min(low, (*samples)[i]);
+                    high = std::max(high, (*samples)[i]);
+                }
+                previous = (*samples)[end - 1];
+
+                const float x = top_left.x + (float)column + 0.5f;
+                Gfx::draw_line_2d_pixels(
+                    {x, sample_to_y(high) - 0.5f}, {x, sample_to_y(low) + 0.5f},
+                    {
+                        .color        = Colors::GREEN,
+                        .depth        = transform->depth,
+                        .anchor_point = Gfx::AnchorPoint::TopLeft,
+                        .line_width   = 1.0f,
+                    });
+            }
+        }
+
+        // Spectrum analyzers
+        for (const auto entity: scene.view<UI::Transform, Value, Spectrum>()) {
+            auto* transform = scene.get_component<UI::Transform>(entity);
+            auto* value     = scene.get_component<Value>(entity);
+            auto* spectrum  = scene.get_component<Spectrum>(entity);
+
+            const glm::vec2 top_left = Gfx::anchor_offset_pixels(transform->top_left, transform->anchor, scene.panel_size);
+            const glm::vec2 bottom_right =
+                Gfx::anchor_offset_pixels(transform->bottom_right, transform->anchor, scene.panel_size);
+            const glm::vec2 size = bottom_right - top_left;
+            const float log_min  = log10f(spectrum->min_hz);
+            const float log_max  = log10f(spectrum->max_hz);
+            const auto hz_to_x   = [&](const float hz) {
+                return top_left.x + (log10f(hz) - log_min) / (log_max - log_min) * size.x;
+            };
+            const auto db_to_y = [&](const float db) {
+                const float position = (db - spectrum->min_db) / (spectrum->max_db - spectrum->min_db);
+                return bottom_right.y - std::clamp(position, 0.0f, 1.0f) * size.y;
+            };
+            const Gfx::DrawParams grid_params = {
+                .color        = Colors::DARK_GREY,
+                .depth        = transform->depth + 0.001f,
+                .anchor_point = Gfx::AnchorPoint::TopLeft,
+                .line_width   = 1.0f,
+            };
+
+            // Background, with grid lines at every power of ten in Hz and every 20 dB
+            Gfx::draw_rectangle_2d_pixels(
+                top_left, bottom_right,
+                {
+                    .color        = Color(0.05f, 0.05f, 0.05f, 1.0f),
+                    .depth        = transform->depth + 0.002f,
+                    .anchor_point = Gfx::AnchorPoint::TopLeft,
+                });
+            for (float hz = powf(10.0f, ceilf(log_min)); hz <= spectrum->max_hz; hz *= 10.0f) {
+                Gfx::draw_line_2d_pixels({hz_to_x(hz), top_left.y}, {hz_to_x(hz), bottom_right.y}, grid_params);
+            }
+            for (float db = ceilf(spectrum->min_db / 20.0f) * 20.0f; db <= spectrum->max_db; db += 20.0f) {
+                Gfx::draw_line_2d_pixels({top_left.x, db_to_y(db)}, {bottom_right.x, db_to_y(db)}, grid_params);
+            }
+
+            const auto* magnitudes = value->get_as_ptr<std::vector<float>>();
+            const double bin_hz    = scene.value_pool.get<double>(spectrum->bin_hz_variable);
+            if (magnitudes == nullptr || magnitudes->size() < 2 || bin_hz <= 0.0) continue;
+
+            // Every pixel column shows the loudest bin in its frequency range. Down low, where a bin is wider than a pixel,
+            // most columns have no bin of their own, so the level gets interpolated between the neighbouring bins there.
+            const size_t last_bin  = magnitudes->size() - 1;
+            const size_t n_columns = (size_t)std::max(size.x, 1.0f);
+            const float hz_ratio   = spectrum->max_hz / spectrum->min_hz;
+            glm::vec2 previous_point{};
+            for (size_t column = 0; column < n_columns; ++column) {
+                const float bin_begin =
+                    (float)(spectrum->min_hz * powf(hz_ratio, (float)column / (float)n_columns) / bin_hz);
+                const float bin_end =
+                    (float)(spectrum->min_hz * powf(hz_ratio, (float)(column + 1) / (float)n_columns) / bin_hz);
+                if (bin_begin >= (float)last_bin) break;
+
+                const size_t first = (size_t)ceilf(bin_begin);
+                const size_t last  = std::min((size_t)bin_end, last_bin);
+                float db;
+                if (first <= last) {
+                    db = *std::max_element(magnitudes->begin() + first, magnitudes->begin() + last + 1);
+                } else {
+                    const size_t below = (size_t)bin_begin;
+                    db                 = std::lerp((*magnitudes)[below], (*magnitudes)[below + 1], bin_begin - (float)below);
+                }
+
+                const glm::vec2 point = {top_left.x + (float)column + 0.5f, db_to_y(db)};
+                if (column > 0) {
+                    Gfx::draw_line_2d_pixels(
+                        previous_point, point,
+                        {
+                            .color        = Colors::CYAN,
+                            .depth        = transform->depth,
+                            .anchor_point = Gfx::AnchorPoint::TopLeft,
+                            .line_width   = 1.0f,
+                        });
+                }
+                previous_point = point;
+            }
+        }
+
         // Radio buttons
         for (const auto entity: scene.view<UI::Transform, Value, RadioButton>()) {
             auto* transform    = scene.get_component<UI::Transform>(entity);
@@ -218,6 +218,51 @@ namespace UI {
                             .default_value         = default_value,
                             .visual_decimal_places = visual_decimal_places};
                         UI::create_numberbox(scene, variable_string.empty() ? name_str : variable_string, trans, range);
+                    } else if (*type == "readout") {
+                        auto visual_decimal_places = (*node_tbl)["visual_decimal_places"].value_or<uint32_t>(1);
+                        auto text_scale            = (*node_tbl)["text_scale"].as_array();
+                        auto text_color            = (*node_tbl)["text_color"].as_array();
+                        auto variable              = (*node_tbl)["variable"].value_or<std::string>("");
+                        auto variable_string       = std::string(variable.begin(), variable.end());
+
+                        const glm::vec2 scale = {
+                            text_scale ? (*text_scale)[0].value_or(2.0f) : 2.0f,
+                            text_scale ? (*text_scale)[1].value_or(2.0f) : 2.0f,
+                        };
+
+                        const glm::vec4 color = {
+                            text_color ? (*text_color)[0].value_or(1.0f) : 1.0f,
+                            text_color ? (*text_color)[1].value_or(1.0f) : 1.0f,
+                            text_color ? (*text_color)[2].value_or(1.0f) : 1.0f,
+                            text_color ? (*text_color)[3].value_or(1.0f) : 1.0f,
+                        };
+
+                        UI::create_readout(
+                            scene, variable_string.empty() ? name_str : variable_string, trans, visual_decimal_places,
+                            Text(
+                                L"", scale, color, string_to_anchor(text_ui_anchor.empty() ? "left" : text_ui_anchor),
+                                string_to_anchor(text_text_anchor.empty() ? "left" : text_text_anchor)));
+                    } else if (*type == "meter") {
+                        auto min_db          = (*node_tbl)["min_db"].value_or<float>(-60.0f);
+                        auto max_db          = (*node_tbl)["max_db"].value_or<float>(6.0f);
+                        auto variable        = (*node_tbl)["variable"].value_or<std::string>("");
+                        auto variable_string = std::string(variable.begin(), variable.end());
+                        UI::create_meter(scene, variable_string.empty() ? name_str : variable_string, trans, min_db, max_db);
+                    } else if (*type == "scope") {
+                        auto range           = (*node_tbl)["range"].value_or<float>(1.0f);
+                        auto variable        = (*node_tbl)["variable"].value_or<std::string>("");
+                        auto variable_string = std::string(variable.begin(), variable.end());
+                        UI::create_scope(scene, variable_string.empty() ? name_str : variable_string, trans, range);
+                    } else if (*type == "spectrum") {
+                        auto min_hz          = (*node_tbl)["min_hz"].value_or<float>(20.0f);
+                        auto max_hz          = (*node_tbl)["max_hz"].value_or<float>(20000.0f);
+                        auto min_db          = (*node_tbl)["min_db"].value_or<float>(-100.0f);
+                        auto max_db          = (*node_tbl)["max_db"].value_or<float>(0.0f);
+                        auto variable        = (*node_tbl)["variable"].value_or<std::string>("");
+                        auto variable_string = std::string(variable.begin(), variable.end());
+                        UI::create_spectrum(
+                            scene, variable_string.empty() ? name_str : variable_string, trans, min_hz, max_hz, min_db,
+                            max_db);
                     } else if (*type == "box") {
                         auto ci               = (*node_tbl)["color_inner"].as_array();
                         auto co               = (*node_tbl)["color_outer"].as_array();
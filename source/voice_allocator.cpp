@@ -0,0 +1,142 @@
+#include "voice_allocator.hpp"
+#include <algorithm>
+#include <atomic>
+
+std::atomic<size_t> global_voice_budget = 1024;
+std::atomic<size_t> global_voices_used  = 0;
+std::atomic<size_t> global_voices_fading = 0;
+
+void VoiceAllocator::set_global_budget(size_t n_voices) { global_voice_budget.store(n_voices, std::memory_order_relaxed); }
+size_t VoiceAllocator::global_budget() { return global_voice_budget.load(std::memory_order_relaxed); }
+size_t VoiceAllocator::n_global_voices() { return global_voices_used.load(std::memory_order_relaxed); }
+size_t VoiceAllocator::n_global_sounding_voices() {
+    // Other processors can change both in between the loads, so don't let that wrap around
+    const size_t n_fading = global_voices_fading.load(std::memory_order_relaxed);
+    const size_t n_used   = global_voices_used.load(std::memory_order_relaxed);
+    return (n_used > n_fading) ? (n_used - n_fading) : 0;
+}
+
+void VoiceAllocator::set_sample_rate(double sample_rate) {
+    this->fade_step = (float)(1.0 / std::max(fade_time * sample_rate, 1.0));
+}
+
+void VoiceAllocator::init(size_t max_polyphony, double sample_rate) {
+    // Spare voices for stolen voices to fade out on
+    const size_t n_spare = std::max(max_polyphony / 4, (size_t)16);
+    const size_t n_total = max_polyphony + n_spare;
+
+    this->max_polyphony = max_polyphony;
+    this->set_sample_rate(sample_rate);
+    this->start_order.assign(n_total, 0);
+    this->fade.assign(n_total, 1.0f);
+    this->fading.assign(n_total, 0);
+
+    // Both lists have room for the whole pool, so they never allocate once we're running
+    global_voices_used.fetch_sub(this->active_voices.size(), std::memory_order_relaxed);
+    global_voices_fading.fetch_sub(this->n_fading, std::memory_order_relaxed);
+    this->n_fading = 0;
+    this->active_voices.clear();
+    this->free_voices.clear();
+    this->active_voices.reserve(n_total);
+    this->free_voices.reserve(n_total);
+    for (size_t i = n_total; i-- > 0;) {
+        this->free_voices.push_back((uint32_t)i);
+    }
+}
+
+VoiceAllocator::~VoiceAllocator() {
+    global_voices_used.fetch_sub(this->active_voices.size(), std::memory_order_relaxed);
+    global_voices_fading.fetch_sub(this->n_fading, std::memory_order_relaxed);
+}
+
+uint32_t VoiceAllocator::allocate(uint8_t key, StealPolicy policy, const VolEnv* vol_envs, const uint8_t* keys) {
+    const size_t n_sounding = this->active_voices.size() - this->n_fading;
+    const bool over_budget  = n_global_sounding_voices() >= global_budget();
+    const bool has_to_steal = (n_sounding >= this->max_polyphony) || over_budget;
+
+    if (has_to_steal) {
+        // Pick the voice to steal, voices that are already fading out don't count
+        uint32_t victim = none;
+        int best_rank   = INT32_MAX;
+        for (const uint32_t voice: this->active_voices) {
+            if (this->fading[voice] || this->start_order[voice] >= this->protected_from) continue;
+
+            // Lower rank gets stolen first, ties go to the oldest voice
+            int rank = 0;
+            if (policy == StealPolicy::release_first) {
+                if (keys[voice] == key) rank = 0;
+                else if (vol_envs[voice].stage == VolEnvStage::release) rank = 1;
+                else rank = 2;
+            }
+
+            bool better = (victim == none) || (rank < best_rank);
+            if (!better && rank == best_rank) {
+                if (policy == StealPolicy::quietest && vol_envs[voice].adsr_volume != vol_envs[victim].adsr_volume) {
+                    better = vol_envs[voice].adsr_volume < vol_envs[victim].adsr_volume;
+                } else {
+                    better = this->start_order[voice] < this->start_order[victim];
+                }
+            }
+            if (better) {
+                victim    = voice;
+                best_rank = rank;
+            }
+        }
+
+        // Nothing left to steal, e.g. because every sounding voice belongs to the note being started. Taking a spare voice
+        // anyway would go over the polyphony or the global budget, so drop this one.
+        if (victim == none) return none;
+
+        this->fading[victim] = 1;
+        this->fade[victim]   = 1.0f;
+        this->n_fading++;
+        global_voices_fading.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // All the spare voices are busy fading out, so cut off the one that's closest to done
+    if (this->free_voices.empty()) {
+        size_t quietest = SIZE_MAX;
+        for (size_t i = 0; i < this->active_voices.size(); ++i) {
+            const uint32_t voice = this->active_voices[i];
+            if (!this->fading[voice]) continue;
+            if (quietest == SIZE_MAX || this->fade[voice] < this->fade[this->active_voices[quietest]]) quietest = i;
+        }
+        if (quietest == SIZE_MAX) return none;
+        this->release(quietest);
+    }
+
+    const uint32_t voice_index = this->free_voices.back();
+    this->free_voices.pop_back();
+    this->active_voices.push_back(voice_index);
+    this->start_order[voice_index] = this->n_voices_started++;
+    this->fade[voice_index]        = 1.0f;
+    this->fading[voice_index]      = 0;
+    global_voices_used.fetch_add(1, std::memory_order_relaxed);
+    return voice_index;
+}
+
+void VoiceAllocator::release(size_t active_index) {
+    const uint32_t voice_index        = this->active_voices[active_index];
+    this->active_voices[active_index] = this->active_voices.back();
+    this->active_voices.pop_back();
+    this->free_voices.push_back(voice_index);
+
+    if (this->fading[voice_index]) {
+        this->fading[voice_index] = 0;
+        this->n_fading--;
+        global_voices_fading.fetch_sub(1, std::memory_order_relaxed);
+    }
+    global_voices_used.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool VoiceAllocator::apply_fade(uint32_t voice_index, float* env, size_t n_samples) {
+    if (!this->fading[voice_index]) return false;
+
+    const float start = this->fade[voice_index];
+    const float step  = this->fade_step;
+    for (size_t i = 0; i < n_samples; ++i) {
+        env[i] *= std::max(start - step * (float)(i + 1), 0.0f);
+    }
+    this->fade[voice_index] = std::max(start - step * (float)n_samples, 0.0f);
+    return this->fade[voice_index] <= 0.0f;
+}
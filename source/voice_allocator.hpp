@@ -0,0 +1,57 @@
+#pragma once
+#include "adsr.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class StealPolicy {
+    oldest = 0,    // Steal the voice that started playing first
+    quietest,      // Steal the voice with the lowest envelope level
+    release_first, // Steal a voice playing the same key, then a voice that's already released, then the oldest one
+    n_policies,
+};
+
+// Hands out voice indices for a processor, and decides which voice to steal once the processor hits its polyphony limit or
+// the global voice budget runs out. Stolen voices don't get cut off, they fade out over `fade_time` on one of a few spare
+// voices, while the new note starts on a fresh one.
+struct VoiceAllocator {
+    static constexpr uint32_t none    = UINT32_MAX;
+    static constexpr double fade_time = 0.005;
+
+    // Not real-time safe. The processor's voice arrays need to have room for pool_size() voices.
+    void init(size_t max_polyphony, double sample_rate);
+    void set_sample_rate(double sample_rate);
+    ~VoiceAllocator();
+    size_t pool_size() const { return fade.size(); }
+    size_t n_active() const { return active_voices.size(); }
+
+    // Voices allocated after this call can't be stolen until the next call, so the unison voices of one note don't steal
+    // from each other. Call this once per note-on.
+    void begin_note() { this->protected_from = this->n_voices_started; }
+    // Get a voice for a new note, stealing one if needed. Returns `none` if there was nothing to steal.
+    uint32_t allocate(uint8_t key, StealPolicy policy, const VolEnv* vol_envs, const uint8_t* keys);
+    // Return the voice at `active_voices[active_index]` to the free list. The last active voice takes its place.
+    void release(size_t active_index);
+    // Multiply the voice's envelope by its fade-out, if it's being stolen. Returns true once the fade has finished.
+    bool apply_fade(uint32_t voice_index, float* env, size_t n_samples);
+
+    // Voices shared by all processors, so a dense passage steals voices instead of overloading the CPU
+    static void set_global_budget(size_t n_voices);
+    static size_t global_budget();
+    // Every voice in use, including the ones fading out after being stolen
+    static size_t n_global_voices();
+    // Voices in use minus the ones fading out, which is what the budget limits. A stolen voice and the note that took its
+    // place would otherwise both count until the fade ends, and every note in a burst would steal one more voice.
+    static size_t n_global_sounding_voices();
+
+    std::vector<uint32_t> active_voices; // Voices that are currently sounding, including the ones fading out
+    std::vector<uint32_t> free_voices;   // Idle voices, used as a stack
+    std::vector<uint64_t> start_order;   // When each voice started, counted in voices started on this processor
+    std::vector<float> fade;             // 1.0 for normal voices, goes down to 0.0 while a stolen voice fades out
+    std::vector<uint8_t> fading;
+    uint64_t n_voices_started = 0;
+    uint64_t protected_from   = 0;
+    size_t max_polyphony      = 0;
+    size_t n_fading           = 0;
+    float fade_step           = 1.0f;
+};
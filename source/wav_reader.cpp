@@ -0,0 +1,64 @@
+#include "wav_reader.hpp"
+#include "log.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    uint16_t read_u16(const uint8_t* bytes) { return (uint16_t)(bytes[0] | (bytes[1] << 8)); }
+
+    uint32_t read_u32(const uint8_t* bytes) {
+        return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    }
+} // namespace
+
+bool WavReader::open(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        LOG(Error, "Failed to open \"%s\" for reading", path);
+        return false;
+    }
+
+    uint8_t riff_header[12];
+    if (fread(riff_header, 1, sizeof(riff_header), file) != sizeof(riff_header) || memcmp(riff_header, "RIFF", 4) != 0 ||
+        memcmp(riff_header + 8, "WAVE", 4) != 0) {
+        LOG(Error, "\"%s\" is not a WAV file", path);
+        fclose(file);
+        return false;
+    }
+
+    // Walk the chunks until we've seen both the format and the data, skipping anything else
+    bool has_format = false;
+    uint8_t chunk_header[8];
+    while (fread(chunk_header, 1, sizeof(chunk_header), file) == sizeof(chunk_header)) {
+        const uint32_t chunk_size = read_u32(chunk_header + 4);
+
+        if (memcmp(chunk_header, "fmt ", 4) == 0) {
+            uint8_t format[16];
+            if (chunk_size < sizeof(format) || fread(format, 1, sizeof(format), file) != sizeof(format)) break;
+            constexpr uint16_t format_ieee_float = 3;
+            if (read_u16(format + 0) != format_ieee_float || read_u16(format + 14) != 32) {
+                LOG(Error, "\"%s\" does not contain 32-bit float samples", path);
+                fclose(file);
+                return false;
+            }
+            this->n_channels  = read_u16(format + 2);
+            this->sample_rate = read_u32(format + 4);
+            has_format        = true;
+            fseek(file, (long)(chunk_size - sizeof(format) + (chunk_size & 1)), SEEK_CUR);
+        } else if (memcmp(chunk_header, "data", 4) == 0 && has_format) {
+            this->samples.resize(chunk_size / sizeof(float));
+            const size_t n_read = fread(this->samples.data(), sizeof(float), this->samples.size(), file);
+            this->samples.resize(n_read);
+            fclose(file);
+            return true;
+        } else {
+            // Chunks are padded to an even size
+            fseek(file, (long)(chunk_size + (chunk_size & 1)), SEEK_CUR);
+        }
+    }
+
+    LOG(Error, "\"%s\" has no audio data", path);
+    fclose(file);
+    return false;
+}
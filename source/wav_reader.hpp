@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Whole WAV file loaded into memory. Only 32-bit float samples are supported, which is what WavWriter writes.
+struct WavReader {
+    bool open(const char* path);
+
+    uint32_t sample_rate = 0;
+    uint16_t n_channels  = 0;
+    std::vector<float> samples; // Interleaved
+};
@@ -0,0 +1,76 @@
+#include "wav_writer.hpp"
+#include "log.hpp"
+
+namespace {
+    void write_u16(FILE* file, uint16_t value) {
+        const uint8_t bytes[2] = {(uint8_t)(value >> 0), (uint8_t)(value >> 8)};
+        fwrite(bytes, 1, sizeof(bytes), file);
+    }
+
+    void write_u32(FILE* file, uint32_t value) {
+        const uint8_t bytes[4] = {(uint8_t)(value >> 0), (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+        fwrite(bytes, 1, sizeof(bytes), file);
+    }
+
+    void write_header(FILE* file, uint32_t sample_rate, uint16_t n_channels, uint32_t data_size) {
+        constexpr uint16_t format_ieee_float = 3;
+        constexpr uint16_t bits_per_sample   = 32;
+        const uint16_t block_align           = n_channels * (bits_per_sample / 8);
+
+        fwrite("RIFF", 1, 4, file);
+        write_u32(file, 36 + data_size);
+        fwrite("WAVE", 1, 4, file);
+        fwrite("fmt ", 1, 4, file);
+        write_u32(file, 16);
+        write_u16(file, format_ieee_float);
+        write_u16(file, n_channels);
+        write_u32(file, sample_rate);
+        write_u32(file, sample_rate * block_align);
+        write_u16(file, block_align);
+        write_u16(file, bits_per_sample);
+        fwrite("data", 1, 4, file);
+        write_u32(file, data_size);
+    }
+} // namespace
+
+WavWriter::~WavWriter() { this->close(); }
+
+bool WavWriter::open(const char* path, uint32_t sample_rate, uint16_t n_channels) {
+    this->close();
+
+    this->file = fopen(path, "wb");
+    if (this->file == nullptr) {
+        LOG(Error, "Failed to open \"%s\" for writing", path);
+        return false;
+    }
+
+    this->sample_rate  = sample_rate;
+    this->n_channels   = n_channels;
+    this->frames_total = 0;
+
+    // Sizes are unknown at this point, they get filled in by close()
+    write_header(this->file, sample_rate, n_channels, 0);
+    return true;
+}
+
+void WavWriter::write(const float* samples, size_t n_frames) {
+    if (this->file == nullptr) return;
+
+    // WAV is little endian, which is what we run on, so the samples can go to disk as-is
+    fwrite(samples, sizeof(float) * this->n_channels, n_frames, this->file);
+    this->frames_total += n_frames;
+}
+
+void WavWriter::close() {
+    if (this->file == nullptr) return;
+
+    const uint64_t data_size = this->frames_total * this->n_channels * sizeof(float);
+    if (data_size > UINT32_MAX - 36) {
+        LOG(Warning, "WAV file exceeds 4 GiB, header sizes will be truncated");
+    }
+
+    fseek(this->file, 0, SEEK_SET);
+    write_header(this->file, this->sample_rate, this->n_channels, (uint32_t)data_size);
+    fclose(this->file);
+    this->file = nullptr;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+// Streams interleaved 32-bit float samples to a WAV file. The header sizes are patched when the file is closed, so the
+// total length does not have to be known up front.
+struct WavWriter {
+    ~WavWriter();
+    bool open(const char* path, uint32_t sample_rate, uint16_t n_channels);
+    void write(const float* samples, size_t n_frames);
+    void close();
+
+    FILE* file            = nullptr;
+    uint32_t sample_rate  = 0;
+    uint16_t n_channels   = 0;
+    uint64_t frames_total = 0;
+};
@@ -0,0 +1,112 @@
+#include "xruns.hpp"
+#include "log.hpp"
+#include "mixer.hpp"
+#include "spsc_ring.hpp"
+#include "voice_allocator.hpp"
+#include <atomic>
+
+namespace Xruns {
+    // A callback counts as late if it starts this many block lengths after the previous one
+    constexpr double late_callback_threshold = 1.75;
+
+    struct {
+        std::atomic<uint64_t> n_underflows     = 0;
+        std::atomic<uint64_t> n_overflows      = 0;
+        std::atomic<uint64_t> n_late_callbacks = 0;
+        std::atomic<uint64_t> n_callbacks      = 0;
+    } counter_values;
+
+    // Audio thread only
+    int64_t prev_callback_ns = 0;
+    size_t prev_n_frames     = 0;
+
+    // Written by the audio thread, read by the UI thread
+    SpscRing<XrunEvent, 256> event_queue;
+    uint64_t n_overflows_reported = 0;
+
+    // UI thread only
+    std::vector<XrunEvent> recent;
+
+    void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void record_callback(const CallbackInfo& info) {
+        const bool has_prev          = prev_callback_ns != 0;
+        const double gap_ms          = has_prev ? ((double)(info.time_ns - prev_callback_ns) / 1'000'000.0) : 0.0;
+        const double expected_gap_ms = (double)prev_n_frames / Mixer::sample_rate() * 1000.0;
+        const bool is_late = info.past_deadline || (has_prev && gap_ms > expected_gap_ms * late_callback_threshold);
+        prev_callback_ns   = info.time_ns;
+        prev_n_frames      = info.n_frames;
+        bump(counter_values.n_callbacks);
+
+        if (!info.output_underflow && !info.output_overflow && !is_late) return;
+
+        XrunEvent event;
+        event.time_ns         = info.time_ns;
+        event.sample_position = Mixer::block_start_sample();
+        event.callback_gap_ms = gap_ms;
+        event.dsp_load        = Mixer::dsp_load().current;
+        event.n_voices        = (uint32_t)VoiceAllocator::n_global_voices();
+
+        if (info.output_underflow) {
+            bump(counter_values.n_underflows);
+            event.type = XrunType::output_underflow;
+            event_queue.push(event);
+        }
+        if (info.output_overflow) {
+            bump(counter_values.n_overflows);
+            event.type = XrunType::output_overflow;
+            event_queue.push(event);
+        }
+        if (is_late) {
+            bump(counter_values.n_late_callbacks);
+            event.type = XrunType::late_callback;
+            event_queue.push(event);
+        }
+    }
+
+    void stream_started() {
+        prev_callback_ns = 0;
+        prev_n_frames    = 0;
+    }
+
+    Counters counters() {
+        Counters result;
+        result.n_underflows     = counter_values.n_underflows.load(std::memory_order_relaxed);
+        result.n_overflows      = counter_values.n_overflows.load(std::memory_order_relaxed);
+        result.n_late_callbacks = counter_values.n_late_callbacks.load(std::memory_order_relaxed);
+        result.n_callbacks      = counter_values.n_callbacks.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void update() {
+        XrunEvent event;
+        while (event_queue.pop(event)) {
+            LOG(Warning, "Xrun: %s at sample %llu (%.2f ms since the previous callback, DSP load %.1f%%, %u voices)",
+                type_name(event.type), (unsigned long long)event.sample_position, event.callback_gap_ms,
+                event.dsp_load * 100.0, event.n_voices);
+
+            if (recent.size() >= max_recent_events) recent.erase(recent.begin());
+            recent.push_back(event);
+        }
+
+        const uint64_t n_overflows = event_queue.n_overflows.load(std::memory_order_relaxed);
+        if (n_overflows != n_overflows_reported) {
+            LOG(Warning, "Xrun event queue overflowed, %llu event(s) not logged",
+                (unsigned long long)(n_overflows - n_overflows_reported));
+            n_overflows_reported = n_overflows;
+        }
+    }
+
+    const std::vector<XrunEvent>& recent_events() { return recent; }
+
+    const char* type_name(XrunType type) {
+        switch (type) {
+            case XrunType::output_underflow: return "output underflow";
+            case XrunType::output_overflow: return "output overflow";
+            case XrunType::late_callback: return "late callback";
+        }
+        return "unknown";
+    }
+} // namespace Xruns
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Detects and records xruns: underflows and overflows reported by the audio driver, and callbacks that came in late. The
+// audio thread records them without blocking, the UI thread collects them with update().
+namespace Xruns {
+    enum class XrunType : uint8_t {
+        output_underflow = 0, // The driver ran out of audio, so there was a dropout
+        output_overflow,      // The driver had to throw away audio we gave it
+        late_callback,        // The callback started after its output was due, or long after the previous one
+    };
+
+    struct XrunEvent {
+        XrunType type;
+        int64_t time_ns;          // Common::time_ns() at the start of the callback that noticed it
+        uint64_t sample_position; // Start of the block that was being rendered
+        double callback_gap_ms;   // Time since the previous callback started
+        double dsp_load;          // Load of the block before it, which is usually the one that caused it
+        uint32_t n_voices;        // Voices playing across all processors
+    };
+
+    struct Counters {
+        uint64_t n_underflows     = 0;
+        uint64_t n_overflows      = 0;
+        uint64_t n_late_callbacks = 0;
+        uint64_t n_callbacks      = 0;
+    };
+
+    constexpr size_t max_recent_events = 64;
+
+    struct CallbackInfo {
+        int64_t time_ns;       // Common::time_ns() at the start of the callback
+        size_t n_frames;
+        bool output_underflow; // Flags reported by the driver
+        bool output_overflow;
+        bool past_deadline;    // The driver's timestamps say the buffer should already be playing
+    };
+
+    // Call this from the audio callback, once per callback, before rendering
+    void record_callback(const CallbackInfo& info);
+    // Forget the previous callback, so the first one of a new stream isn't measured against the old stream's timing. Call
+    // this right before starting a stream, while no callback can be running.
+    void stream_started();
+    // Lock-free, can be called from any thread
+    Counters counters();
+    // Collect new events from the audio thread and log them. Call this from the main loop.
+    void update();
+    // The last `max_recent_events` events, oldest first. Only valid on the thread that calls update().
+    const std::vector<XrunEvent>& recent_events();
+    const char* type_name(XrunType type);
+} // namespace Xruns